@@ -3,21 +3,65 @@
 #include <string>
 #include <format>
 #include <iostream>
+#include <memory>
+#include <cassert>
+#include <map>
+#include <filesystem>
 
 #include "Texture.hpp"
 #include "Camera.hpp"
 #include "ShaderProgram.hpp"
+#include "Light.hpp"
+#include "platform/Headless.hpp"
 #include "scene/Model.hpp"
+#include "scene/ImportCache.hpp"
+#include "scene/ClusteredLighting.hpp"
+#include "render/RenderSnapshot.hpp"
+#include "render/GeometryBuffers.hpp"
+#include "assets/AssetStreamer.hpp"
+#include "io/VirtualFileSystem.hpp"
 
 struct GLFWwindow;
 
 namespace dlb {
 
-	struct GlobalLight {
-		glm::vec3 ambient;
-		glm::vec3 diffuse;
-		glm::vec3 specular;
-		glm::vec3 direction;
+	/*
+	* Command line configuration, must be set before the first getInstance().
+	*/
+	struct LaunchOptions {
+		// render offscreen through HeadlessContext instead of a GLFW window
+		bool headless = false;
+		// stop after this many frames, 0 runs until the window is closed
+		int frames = 0;
+		// per-frame CPU/GPU timings, written on exit
+		std::string bench_output;
+		// final frame as PPM (headless only)
+		std::string screenshot;
+		// session frame-time percentiles and hitches, written on exit
+		std::string stats_output;
+		// CPU zones of the whole run as Chrome trace JSON, written on exit
+		std::string trace_output;
+		// submit GL from a dedicated render thread, pipelined with the simulation
+		bool render_thread = true;
+		// simulation step in seconds, 0 uses the real frame time
+		double fixed_delta_time = 0.0;
+		int width = 1000;
+		int height = 700;
+		// GL time spent uploading streamed models per frame
+		double upload_budget_ms = 2.0;
+		// block compressed textures through the KTX2 cache
+		bool compress_textures = true;
+		// estimated texture VRAM before Texture2DPool evicts, 0 is unlimited
+		int texture_budget_mb = 1024;
+		// scene::ImportCache directory, empty disables it
+		std::string import_cache = ".cache/import";
+		int import_cache_mb = 512;
+		// loose directory `res://` paths resolve to
+		std::string resources = RESOURCES_PATH;
+		// .dlbp pack looked up before the loose directory, empty uses the directory only
+		std::string resource_pack;
+		// LoadStats JSON, written once every shader and model is loaded
+		std::string startup_report;
 	};
 
 	class ApplicationSingleton {
@@ -28,8 +72,8 @@ namespace dlb {
 			bg_color{ 0.0f, 0.0f, 0.0f }
 		{
 			window_title = "physics engine";
-			window_dims.x = 1000;
-			window_dims.y = 700;
+			window_dims.x = launchOptions().width;
+			window_dims.y = launchOptions().height;
 
 			init();
 
@@ -51,13 +95,41 @@ namespace dlb {
 
 			texture_pool = &dlb::Texture2DPool::getInstance();
 
-			// load Bounding box shader
-			aabb_shader_ = addShader(dlb::ShaderProgramBuilder{}
-				.vertexShader("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\shaders\\AABB.vert")
-				.fragmentShader("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\shaders\\AABB.frag"));
+			auto& vfs = dlb::VirtualFileSystem::getInstance();
+			vfs.mountDirectory(launchOptions().resources);
+
+			// without the pack everything still loads from the directory
+			if (!launchOptions().resource_pack.empty())
+				vfs.mountPack(launchOptions().resource_pack);
+
+			scene::ImportCache::getInstance().configure(launchOptions().import_cache, (u64)std::max(0, launchOptions().import_cache_mb) << 20);
+
+			// BC5 (RGTC) is core, BC1/BC3 need S3TC which every desktop driver has
+			texture_pool->setCompression(launchOptions().compress_textures && GLAD_GL_EXT_texture_compression_s3tc);
+			texture_pool->setBudget((size_t)std::max(0, launchOptions().texture_budget_mb) << 20);
+
+			// getModel references must stay valid while models are added
+			models_.reserve(MAX_MODELS);
+
+			// drawn instead of any program that is still compiling, so it is built right away
+			placeholder_shader_ = shaders_.size();
+			shaders_.push_back(dlb::ShaderProgramBuilder{}
+				.vertexShader("res://shaders/Model.vert")
+				.fragmentShader("res://shaders/Placeholder.frag")
+				.vertexInputs(dlb::vertexShaderInputs<scene::Vertex>())
+				.build());
+			initPlaceholderBox();
+
+			// debug lines (bounding boxes)
+			debug_shader_ = addShader(dlb::ShaderProgramBuilder{}
+				.vertexShader("res://shaders/Debug.vert")
+				.fragmentShader("res://shaders/Debug.frag")
+				.vertexInputs(dlb::vertexShaderInputs<dlb::DebugVertex>()));
 		}
 	private:
 		void init();
+		void initHeadless();
+		void initPlaceholderBox();
 		//void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
 		//GLFWwindow* createWindow(int w, int h, const char* title);
 		//void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -68,6 +140,63 @@ namespace dlb {
 			return instance;
 		}
 
+		static LaunchOptions& launchOptions() {
+			static LaunchOptions options{};
+			return options;
+		}
+
+		bool isHeadless() const {
+			return launchOptions().headless;
+		}
+
+		/*
+		* False once the window is closed or the frame budget is spent.
+		*/
+		bool running();
+
+		/*
+		* Swaps the window buffers, render thread only. Nothing to do when headless.
+		*/
+		void present();
+
+		/*
+		* Window and input events, must run on the main thread.
+		*/
+		void pollEvents();
+
+		/*
+		* Binds the GL context (window or headless) to the calling thread or
+		* releases it, used to hand the context to the render thread.
+		*/
+		void makeContextCurrent(bool current);
+
+		/*
+		* Camera, lights and frame settings of the simulation state, the
+		* draw packets are added by the entity pool.
+		*/
+		void fillSnapshot(RenderSnapshot& frame);
+
+		/*
+		* Draws the scene of `frame`, owns every GL call so it runs on the
+		* render thread.
+		*/
+		void render(const RenderSnapshot& frame);
+
+		/*
+		* Executes sorted commands, must not allocate.
+		*/
+		void replay(const RenderSnapshot& frame, std::span<const RenderCommandKey> commands);
+
+		/*
+		* The imported bounds of `model` (a unit cube before that) drawn with
+		* the placeholder program.
+		*/
+		void drawPlaceholder(const scene::Model& model, const RenderSnapshot& frame, const glm::mat4& transform);
+
+		HeadlessContext& getHeadlessContext() {
+			return headless_;
+		}
+
 		inline const glm::vec2& getWindowDims() const {
 			return window_dims;
 		}
@@ -124,14 +253,29 @@ namespace dlb {
 			last_cursor_pos.y = val;
 		}
 
-		int getFrames() {
-			return frames;
-		}
-
 		auto& getGlobalLight() {
 			return global_light;
 		}
 
+		std::vector<LocalLight>& getLights() {
+			return lights_;
+		}
+
+		uint addLight(const LocalLight& light) {
+			lights_.push_back(light);
+			return lights_.size() - 1;
+		}
+
+		scene::ClusteredLighting& getClusteredLighting() {
+			return clustered_lighting_;
+		}
+
+		/*
+		* Assigns the local lights of `frame` to the light clusters of its
+		* camera, must be called once per frame before drawing.
+		*/
+		void updateLights(const RenderSnapshot& frame);
+
 		auto& getBgColor() {
 			return bg_color;
 		}
@@ -140,29 +284,83 @@ namespace dlb {
 			std::cerr << std::format("[ERROR]: {}:{} {}\n", filename, function, error_msg);
 		}
 
+		/*
+		* Starts streaming the model in and returns its id right away, it is
+		* drawn as a placeholder box until it is resident. A path already
+		* added with the same flags returns the id of that model, entities
+		* share it.
+		*/
 		uint addModel(const char* path, uint flags) {
-			models_.push_back({ path, flags });
+			const auto key = std::make_pair(std::filesystem::path(path).lexically_normal().string(), flags);
+
+			if (auto found = model_ids_.find(key); found != model_ids_.end())
+				return found->second;
+
+			assert(models_.size() < MAX_MODELS);
+
+			models_.push_back(std::make_unique<scene::Model>(path, flags));
+			asset_streamer_.request(models_.back().get());
+			model_ids_.emplace(key, models_.size() - 1);
 			return models_.size() - 1;
 		}
 
+		/*
+		* Simulation thread: picks up the bounds of the models imported since
+		* the last call. Called once per frame.
+		*/
+		void updateModels();
+
+		/*
+		* Blocks until every added model is resident, GL thread only.
+		*/
+		void finishModels();
+
+		/*
+		* Every queued program linked and every added model resident (or
+		* failed), GL thread only. Ends the startup report.
+		*/
+		bool isLoaded() const;
+
+		/*
+		* Queues the program for the next submitShaders() and returns its id
+		* right away, getShader() returns the placeholder program until it is linked.
+		*/
 		uint addShader(dlb::ShaderProgramBuilder& builder) {
-			shaders_.push_back(builder.build());
+			shaders_.emplace_back(0);
+			shader_batch_.add(builder);
+			batch_shader_ids_.push_back(shaders_.size() - 1);
 			return shaders_.size() - 1;
 		}
 
+		/*
+		* Starts compiling every queued program at once.
+		*/
+		void submitShaders();
+
+		/*
+		* Swaps in the programs that finished compiling, never blocks when
+		* GL_KHR_parallel_shader_compile is available. Called once per frame.
+		*/
+		void pollShaders();
+
+		/*
+		* Blocks until every queued program is linked.
+		*/
+		void finishShaders();
+
 		scene::Model& getModel(uint model_id) {
 			if (model_id >= models_.size())
 				abort();
 
-			return models_[model_id];
+			return *models_[model_id];
 		}
 
 		const dlb::ShaderProgram& getShader(uint id) const {
-			return shaders_[id];
+			return shaders_[id].isReady() ? shaders_[id] : shaders_[placeholder_shader_];
 		}
 
-		uint getAABBShader() const {
-			return aabb_shader_;
+		uint getDebugShader() const {
+			return debug_shader_;
 		}
 
 		void updateTime();
@@ -172,7 +370,7 @@ namespace dlb {
 		}
 
 	private:
-		GLFWwindow* window_;
+		GLFWwindow* window_ = nullptr;
 		glm::vec2 window_dims;
 		glm::vec2 last_cursor_pos;
 		glm::vec3 bg_color;
@@ -180,7 +378,6 @@ namespace dlb {
 
 		double delta_time;
 		double last_frame;
-		double last_time = 0.0F;
 
 		dlb::Camera camera;
 
@@ -189,13 +386,30 @@ namespace dlb {
 		//bool init_;
 
 		GlobalLight global_light;
+		std::vector<LocalLight> lights_;
+		scene::ClusteredLighting clustered_lighting_;
 
-		int frames = 0;
+		int frame_count_ = 0;
+
+		HeadlessContext headless_;
 
 		dlb::Texture2DPool* texture_pool;
 
-		std::vector<scene::Model> models_;
+		static constexpr uint MAX_MODELS = 1024;
+
+		std::vector<std::unique_ptr<scene::Model>> models_;
+		// (normalized path, flags) -> index in models_
+		std::map<std::pair<std::string, uint>, uint> model_ids_;
+		dlb::AssetStreamer asset_streamer_;
+		// unit cube standing in for models that are not resident yet
+		dlb::GeometryBuffers placeholder_box_;
 		std::vector<dlb::ShaderProgram> shaders_;
-		uint aabb_shader_;
+		uint debug_shader_;
+		dlb::DebugRenderer debug_renderer_;
+		uint placeholder_shader_;
+
+		// programs added with addShader, batch entry i fills shaders_[batch_shader_ids_[i]]
+		dlb::ShaderBatch shader_batch_;
+		std::vector<uint> batch_shader_ids_;
 	};
 }
\ No newline at end of file
@@ -12,6 +12,11 @@ namespace dlb {
 	public:
 		const glm::mat4& getView();
 
+		/*
+		* Perspective projection shared by every draw and the light clusters.
+		*/
+		glm::mat4 getProjection(float aspect) const;
+
 	public:
 		inline const glm::vec3& getPosition() const { return position; }
 		inline const glm::vec3& getDirection() const { return direction; }
@@ -29,6 +34,10 @@ namespace dlb {
 			return camera_speed;
 		}
 
+		inline float getFov() const { return fov; }
+		inline float getNear() const { return z_near; }
+		inline float getFar() const { return z_far; }
+
 	private:
 		float getCameraSpeed();
 		void updateView();
@@ -42,6 +51,9 @@ namespace dlb {
 		glm::mat4 view;
 
 		float camera_speed = 3.0f;
+		float fov = 45.0f;
+		float z_near = 0.1f;
+		float z_far = 100.0f;
 		float yaw = -90.0f;
 		float pitch = 0.0f;
 };
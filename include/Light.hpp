@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace dlb {
+	/*
+	* Directional light shading the whole scene.
+	*/
+	struct GlobalLight {
+		glm::vec3 ambient;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+		glm::vec3 direction;
+	};
+
+	/*
+	* Point or spot light with a finite range, shaded through the light clusters.
+	* The layout matches the 4 RGBA32F texels per light read by the shaders.
+	*/
+	struct LocalLight {
+		glm::vec3 position;
+		float radius;
+
+		glm::vec3 diffuse;
+		// cosine of the cone half-angle, -1 for point lights
+		float spot_cutoff = -1.0f;
+
+		glm::vec3 specular;
+		float padding0 = 0.0f;
+
+		glm::vec3 direction{ 0.0f, -1.0f, 0.0f };
+		float padding1 = 0.0f;
+	};
+
+	static_assert(sizeof(LocalLight) == 16 * sizeof(float), "LocalLight must be 4 vec4s.");
+}
@@ -1,28 +1,48 @@
+#pragma once
+
 #include <vector>
-#include <functional>
+#include <cassert>
 
-#include <gl/GL.h>
+#include <glad/glad.h>
 
 #include "ShaderProgram.hpp"
 #include "Material.hpp"
 #include "Texture.hpp"
+#include "render/VertexLayout.hpp"
 
 namespace dlb {
 
 	/*
 	* Represents a renderable object.
 	* This class contains the VAO and VBO necessary to send data
-	* to the GPU.
+	* to the GPU, the attributes come from `V::attributes()`.
 	*/
+	template<VertexType V>
 	class Renderable {
 	public:
-		Renderable(bool _use_ebo = false);
-		~Renderable();
+		Renderable(bool _use_ebo = false) {
+			use_ebo = _use_ebo;
+			glGenVertexArrays(1, &vao);
+			glGenBuffers(1, &vbo);
+
+			if (use_ebo)
+				glGenBuffers(1, &ebo);
+		}
+
+		~Renderable() {
+			glDeleteVertexArrays(1, &vao);
+			glDeleteBuffers(1, &vbo);
+
+			if (use_ebo)
+				glDeleteBuffers(1, &ebo);
+		}
+
+		Renderable(const Renderable&) = delete;
+		Renderable& operator=(const Renderable&) = delete;
 
 	public:
-		void feedData(std::vector<float>&& verts, int verts_no) {
+		void feedData(std::vector<V>&& verts) {
 			vertices = std::move(verts);
-			vertices_no = verts_no;
 		}
 
 		void setShaderProgram(const dlb::ShaderProgram* sp) {
@@ -37,10 +57,6 @@ namespace dlb {
 			use_material = x;
 		}
 
-		void useEBO(bool x) {
-			use_ebo = x;
-		}
-
 		void setIndices(std::vector<GLuint>&& idx) {
 			indices = std::move(idx);
 		}
@@ -52,30 +68,55 @@ namespace dlb {
 	public:
 
 		/*
-		* Configures the VBO.
-		* @param configuration Expects a function that calls `glVertexAttribPointer`
-		*	to configure the attributes of the VBO. A typical `configuration` function
-		*	should be a lambda with:
-		*	```cpp
-		*		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(vertices[0]), NULL);
-		*		glEnableVertexAttribArray(0);
-		*		// configure more attributes...
-		*	```
+		* Uploads the vertices (and indices) and sets the attribute pointers of `V`.
 		*/
-		void configureVertexAttributes(GLenum target, GLenum usage, const std::function<void(void)>& configuration);
+		void upload(GLenum usage = GL_STATIC_DRAW) {
+			glBindVertexArray(vao);
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(V) * vertices.size(), vertices.data(), usage);
+
+			if (use_ebo) {
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+				glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), usage);
+			}
+
+			setupVertexAttributes<V>();
 
-		void render(const std::function<void(const dlb::ShaderProgram*, dlb::Texture2DGroup*)>& pre_render);
+			glBindVertexArray(0);
+		}
+
+		/*
+		* `pre_render(const ShaderProgram*, Texture2DGroup*)` sets the uniforms,
+		*	it is called with the program in use and the VAO bound.
+		*/
+		template<typename F>
+		void render(F&& pre_render) {
+			if (!do_render)
+				return;
+
+			assert(shader_program != nullptr && "Shader Program is not defined");
+
+			shader_program->use();
+
+			glBindVertexArray(vao);
+
+			pre_render(shader_program, textures);
+
+			if (!use_ebo)
+				glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+			else
+				glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+		}
 
 	private:
-		GLuint vao, vbo, ebo;
+		GLuint vao = 0, vbo = 0, ebo = 0;
 
 		bool do_render = true;
 		bool use_material = true;
 		bool use_ebo = false;
 
-		int vertices_no;
-		std::vector<float> vertices;
-		const dlb::ShaderProgram* shader_program;
+		std::vector<V> vertices;
+		const dlb::ShaderProgram* shader_program = nullptr;
 		std::vector<GLuint> indices;
 
 		/*
@@ -90,4 +131,4 @@ namespace dlb {
 
 		dlb::Texture2DGroup* textures = nullptr;
 	};
-}
\ No newline at end of file
+}
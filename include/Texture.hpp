@@ -3,17 +3,30 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <list>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <atomic>
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
 #include <cassert>
 
+#include "Types.hpp"
+#include "render/StagingBuffer.hpp"
+#include "render/BlockCompression.hpp"
+
 namespace dlb {
 	enum Texture2DType {
 		Whatever = 0,
 		Specular,
-		Diffuse
+		Diffuse,
+		// tangent space, compressed to BC5 (XY)
+		Normal
 	};
 
 	struct Texture2D {
@@ -31,28 +44,63 @@ namespace dlb {
 
 	class Texture2DGroupBuilder;
 
-	class Texture2DGroup {
-	private:
-		Texture2DGroup() {};
+	/*
+	* Pixels decoded by stb_image, freed with the image, or the block
+	* compressed mip chain from the texture cache.
+	*/
+	class DecodedImage {
+	public:
+		DecodedImage() {}
+		~DecodedImage();
 
+		DecodedImage(const DecodedImage&) = delete;
+		DecodedImage(DecodedImage&& x) noexcept;
+		DecodedImage& operator=(DecodedImage&& x) noexcept;
 
 	public:
-		Texture2DGroup(Texture2DGroup&& rhs) = default;
+		/*
+		* `desired_channels` 0 keeps the channels of the file. No GL, any thread.
+		*/
+		bool load(const std::string& path, int desired_channels);
 
-		~Texture2DGroup() {
-			// drawback of having an array of texture2D instead of an array of ints
-			// maybe refactor this later so all textures can be deleted in one call.
+		size_t bytes() const {
+			return (size_t)width * height * channels;
+		}
 
-			/*
+		bool isCompressed() const {
+			return !compressed.empty();
+		}
 
-			std::cout << "Deleting textures" << textures.size() << std::endl;
+	public:
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		unsigned char* pixels = nullptr;
 
-			for (int i = 0; i < textures.size(); i++) {
-				glDeleteTextures(1, &textures[i].d);
-			}
-			*/
+		// used instead of the pixels when not empty
+		CompressedImage compressed;
+	};
+
+	/*
+	* Holds one Texture2DPool reference on each of its textures, released
+	* when the group is destroyed. GL thread only.
+	*/
+	class Texture2DGroup {
+	private:
+		Texture2DGroup() {};
+
+	public:
+		Texture2DGroup(Texture2DGroup&& rhs) noexcept
+			:textures(std::move(rhs.textures)) {
+			rhs.textures.clear();
 		}
 
+		Texture2DGroup& operator=(Texture2DGroup&& rhs) noexcept;
+
+		Texture2DGroup(const Texture2DGroup&) = delete;
+
+		~Texture2DGroup();
+
 	protected:
 		void setTextures(std::vector<Texture2D>&& texs) {
 			textures = std::move(texs);
@@ -64,12 +112,15 @@ namespace dlb {
 		}
 
 		void use() {
-			for (int i = 0; i < textures.size(); i++) {
+			for (uint i = 0; i < textures.size(); i++) {
 				glActiveTexture(GL_TEXTURE0 + i);
 				glBindTexture(GL_TEXTURE_2D, textures[i].id);
 			}
 		}
 
+	private:
+		void release();
+
 	private:
 		std::vector<Texture2D> textures;
 
@@ -113,11 +164,190 @@ namespace dlb {
 			return *this;
 		}
 
-		Texture2DGroup build();
+		/*
+		* Decodes every configured texture on the thread pool and returns once
+		*	all are done. No GL so it runs on any thread, paths shared with
+		*	other builders are decoded once through the Texture2DPool.
+		*/
+		void decode();
+
+		/*
+		* Uploads the next texture (decoding all of them first when decode()
+		*	was not called), a texture already in the Texture2DPool is reused.
+		*	Returns true once every texture is uploaded. GL thread only.
+		*/
+		bool uploadNext(StagingBuffer* staging = nullptr);
+
+		/*
+		* Uploads the remaining textures in order and returns the group.
+		*	GL thread only.
+		*/
+		Texture2DGroup build(StagingBuffer* staging = nullptr);
 	
 	public:
 		int current_tex = 0;
 		std::vector<Texture2DConfiguration> textures;
+
+	private:
+		// filled by decode(), consumed by build()
+		std::vector<std::shared_ptr<DecodedImage>> decoded_;
+		bool decoded_all_ = false;
+
+		// filled by uploadNext(), handed over by build()
+		std::vector<Texture2D> built_;
+		uint next_ = 0;
+	};
+
+	/*
+	* Location of a texture inside a Texture2DArraySet.
+	* `array` is the index of the GL_TEXTURE_2D_ARRAY inside the set (-1 when the
+	*	texture could not be packed), `layer` the layer inside that array and
+	*	`uv_rect` the (offset.xy, scale.xy) of the sub-image for atlased textures.
+	*/
+	struct Texture2DLayer {
+		int array = -1;
+		int layer = 0;
+		glm::vec4 uv_rect{ 0.0f, 0.0f, 1.0f, 1.0f };
+	};
+
+	class Texture2DArrayPacker;
+
+	/*
+	* Set of GL_TEXTURE_2D_ARRAY objects produced by a Texture2DArrayPacker.
+	* Every array is bound once per draw batch, meshes only select a layer.
+	*/
+	class Texture2DArraySet {
+	public:
+		static constexpr int MAX_ARRAYS = 4;
+
+		Texture2DArraySet() {}
+
+		Texture2DArraySet(const Texture2DArraySet&) = delete;
+
+		Texture2DArraySet(Texture2DArraySet&& rhs) noexcept
+			:arrays_(std::move(rhs.arrays_)) {
+			rhs.arrays_.clear();
+		}
+
+		Texture2DArraySet& operator=(Texture2DArraySet&& rhs) noexcept {
+			std::swap(arrays_, rhs.arrays_);
+			return *this;
+		}
+
+		~Texture2DArraySet() {
+			if (!arrays_.empty())
+				glDeleteTextures(arrays_.size(), arrays_.data());
+		}
+
+	public:
+		int size() const {
+			return arrays_.size();
+		}
+
+		/*
+		* Binds array i to texture unit `first_unit + i`.
+		*/
+		void use(int first_unit = 0) const {
+			for (uint i = 0; i < arrays_.size(); i++) {
+				glActiveTexture(GL_TEXTURE0 + first_unit + i);
+				glBindTexture(GL_TEXTURE_2D_ARRAY, arrays_[i]);
+			}
+		}
+
+	private:
+		std::vector<GLuint> arrays_;
+
+		friend class Texture2DArrayPacker;
+	};
+
+	/*
+	* Import-stage texture packer.
+	* Textures are decoded as RGBA8, textures of the same size share a
+	*	GL_TEXTURE_2D_ARRAY (one layer each) and textures smaller than
+	*	`atlasThreshold` are shelf-packed into atlas pages which become the
+	*	layers of one more array. Meshes keep a Texture2DLayer instead of texture
+	*	bindings so a whole model draws with a single bind per array.
+	* Textures past MAX_ARRAYS sizes or GL_MAX_ARRAY_TEXTURE_LAYERS layers
+	*	are left out, their Texture2DLayer keeps array -1.
+	*/
+	class Texture2DArrayPacker {
+	public:
+		Texture2DArrayPacker() {}
+
+	public:
+		/*
+		* Registers a texture and returns its slot, the same path always maps
+		* to the same slot.
+		*/
+		uint add(const std::string& path);
+
+		Texture2DArrayPacker& atlasThreshold(int px) {
+			atlas_threshold_ = px;
+			return *this;
+		}
+
+		Texture2DArrayPacker& atlasSize(int px) {
+			atlas_size_ = px;
+			return *this;
+		}
+
+		bool empty() const {
+			return paths_.empty();
+		}
+
+		/*
+		* Decodes every registered texture on the thread pool, no GL so it
+		*	runs on any thread.
+		*/
+		void decode();
+
+		/*
+		* Uploads one array layer or atlas page, packing every registered
+		*	texture first on the first call (decoding them when decode() was
+		*	not called). Returns true once everything is uploaded. GL thread only.
+		*/
+		bool uploadNext(StagingBuffer* staging = nullptr);
+
+		/*
+		* Uploads the remaining layers and returns the arrays. GL thread only.
+		*/
+		Texture2DArraySet build(StagingBuffer* staging = nullptr);
+
+		/*
+		* Location of a slot, valid after the first uploadNext().
+		*/
+		const Texture2DLayer& layer(uint slot) const {
+			assert(slot < layers_.size());
+			return layers_[slot];
+		}
+
+	private:
+		std::vector<std::string> paths_;
+		std::unordered_map<std::string, uint> slots_;
+		std::vector<Texture2DLayer> layers_;
+		std::vector<DecodedImage> images_;
+
+		// one array layer or atlas page, filled by plan()
+		struct LayerUpload {
+			uint array;
+			uint layer;
+			int width, height;
+			const unsigned char* pixels;
+			size_t bytes;
+			// the array gets its mipmaps after this one
+			bool last_layer;
+		};
+
+		void plan();
+
+		Texture2DArraySet set_;
+		std::vector<std::vector<unsigned char>> pages_;
+		std::vector<LayerUpload> uploads_;
+		uint next_upload_ = 0;
+		bool planned_ = false;
+
+		int atlas_threshold_ = 256;
+		int atlas_size_ = 1024;
 	};
 
 	class Texture2DPool {
@@ -132,23 +362,122 @@ namespace dlb {
 
 	public:
 		bool exists(const std::string& path) {
+			std::lock_guard lock{ mutex_ };
 			return texture_pool_.find(path) != texture_pool_.end();
 		}
 
-		Texture2D& reuse(const std::string& path) {
-			assert(exists(path));
-			return texture_pool_.at(path);
+		/*
+		* Adds a reference to the texture of `path`, it must exist.
+		*/
+		Texture2D reuse(const std::string& path);
+
+		/*
+		* Drops a reference, the texture stays resident for reuse until the
+		*	budget needs its memory. GL thread only.
+		*/
+		void release(GLuint id);
+
+		/*
+		* Any thread: decodes `texture` once however many threads ask for it
+		*	at the same time, the others wait for the same image. Returns
+		*	nullptr when the texture is already uploaded.
+		*/
+		std::shared_ptr<DecodedImage> decode(const Texture2DConfiguration& texture);
+
+		/*
+		* Load block compressed textures from the KTX2 cache (compressing and
+		*	writing it on first use) instead of decoding the sources.
+		*/
+		void setCompression(bool enable) {
+			compress_ = enable;
+		}
+
+		/*
+		* Estimated VRAM the pool may keep, 0 is unlimited. Over budget the
+		*	least recently released unreferenced textures are deleted first,
+		*	then the largest referenced ones lose their top mip (only the
+		*	compressed ones, they are reloaded smaller from the KTX2 cache).
+		*/
+		void setBudget(size_t bytes);
+
+		/*
+		* GL thread: uploads the smaller mips of textures shrunk under the
+		*	budget, read on the thread pool, until `deadline` (FrameStats::nowNs
+		*	clock). At least one per call when any is ready.
+		*/
+		void uploadDroppedMips(u64 deadline);
+
+		/*
+		* Any thread.
+		*/
+		size_t getResidentBytes() const {
+			return resident_bytes_.load(std::memory_order_relaxed);
+		}
+
+		size_t getBudget() const {
+			return budget_;
 		}
 	
 	protected:
 		friend class Texture2DGroupBuilder;
 
-		void insert(const std::string& path, Texture2D& tex) {
-			assert(!exists(path));
-			texture_pool_.insert({ path, tex });
-		}
+		/*
+		* GL thread, the texture starts with one reference. Also drops the
+		*	decoded pixels of `path` once every builder holding them is done.
+		*/
+		void insert(const std::string& path, const Texture2D& tex, size_t bytes, bool compressed);
+
+	private:
+		struct Entry {
+			Texture2D texture;
+			uint refs = 0;
+			// estimated, mips included
+			size_t bytes = 0;
+			bool compressed = false;
+			// top levels dropped under pressure
+			int dropped_levels = 0;
+			// its next level is being read
+			bool shrinking = false;
+			// false once it is as small as it gets
+			bool shrinkable = true;
+			// position in lru_ while unreferenced
+			std::list<std::string>::iterator lru;
+		};
+
+		// a referenced texture to shrink by one level, its KTX2 read on the pool
+		struct MipDrop {
+			std::string path;
+			GLuint id = 0;
+			// top levels dropped once uploaded
+			int skip = 0;
+			CompressedImage image;
+			bool valid = false;
+		};
+
+		/*
+		* GL thread, without the lock: evicts unreferenced textures and
+		*	queues the reads of the smaller mips of the largest referenced ones.
+		*/
+		void trim();
+		void evict(const std::string& path);
+		void readDroppedMips(MipDrop&& drop);
 
 	private:
-		std::unordered_map<std::string, Texture2D> texture_pool_;
+		// the decode jobs read it, the GL thread writes it
+		std::mutex mutex_;
+		std::unordered_map<std::string, Entry> texture_pool_;
+		std::unordered_map<GLuint, std::string> paths_;
+		std::unordered_map<std::string, std::shared_future<std::shared_ptr<DecodedImage>>> decoding_;
+
+		// unreferenced textures, least recently released first
+		std::list<std::string> lru_;
+		// read by readDroppedMips(), waiting for uploadDroppedMips()
+		std::deque<MipDrop> drops_;
+
+		size_t budget_ = 0;
+		// written under the lock, read anywhere
+		std::atomic<size_t> resident_bytes_ = 0;
+
+		std::atomic<bool> compress_ = false;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <future>
+#include <atomic>
+
+#include "Types.hpp"
+#include "scene/Model.hpp"
+#include "render/StagingBuffer.hpp"
+
+namespace dlb {
+
+	/*
+	* Loads models in the background: request() imports on the thread pool
+	* (file, meshes and texture decoding), update() uploads the imported ones
+	* on the render thread within a per-frame time budget. Until a model is
+	* Resident it is drawn as a placeholder.
+	*/
+	class AssetStreamer {
+	public:
+		AssetStreamer() {}
+		~AssetStreamer();
+
+		AssetStreamer(const AssetStreamer&) = delete;
+
+	public:
+		/*
+		* Any thread, `model` must outlive the streamer.
+		*/
+		void request(scene::Model* model);
+
+		/*
+		* Render thread: uploads slices of the imported models for about
+		*	`budget_ms`, the oldest model first. Returns the models made Resident.
+		*/
+		uint update(double budget_ms);
+
+		/*
+		* Render thread: blocks until every requested model is Resident (or
+		*	failed), used before benchmarks and screenshots.
+		*/
+		void finish();
+
+		/*
+		* Models requested and not yet Resident.
+		*/
+		uint pendingCount() const {
+			return pending_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		void waitImports();
+
+	private:
+		std::vector<std::future<void>> imports_;
+
+		// filled by the import jobs
+		std::mutex mutex_;
+		std::deque<scene::Model*> imported_;
+
+		// render thread only
+		std::deque<scene::Model*> uploading_;
+		StagingBuffer staging_;
+
+		std::atomic<uint> pending_{ 0 };
+	};
+}
@@ -9,6 +9,9 @@
 #include <format>
 
 #include "Application.hpp"
+#include "profiling/CpuProfiler.hpp"
+#include "render/RenderSnapshot.hpp"
+#include "scene/Frustum.hpp"
 
 namespace ecs {
 
@@ -19,6 +22,11 @@ namespace ecs {
 			glm::vec3 velocity;
 			glm::vec3 position;
 		} movement;
+
+		struct {
+			// red when colliding with another entity
+			glm::vec3 bb_color;
+		} debug;
 	};
 
 	struct Entity {
@@ -41,10 +49,14 @@ namespace ecs {
 
 	public:
 
-		const std::vector<Entity>& getEntities() {
+		const std::vector<Entity>& getEntities() const {
 			return entities_;
 		}
 
+		const Components& getComponents(uint id) const {
+			return components_[id];
+		}
+
 		uint newEntity(glm::vec3 pos0, glm::vec3 vel0, glm::vec3 accel0, uint shader_id, uint model_id) {
 			auto& context = dlb::ApplicationSingleton::getInstance();
 
@@ -96,6 +108,8 @@ namespace ecs {
 		}
 
 		void iterate() {
+			PROFILE_ZONE("EntityPool::iterate");
+
 			auto& context = dlb::ApplicationSingleton::getInstance();
 
 			if (context.getPauseEcs())
@@ -132,12 +146,75 @@ namespace ecs {
 						bb_color.g = 1.0f;
 				}
 
-				model.translate(mov.position);
+				components_[entity.id].debug.bb_color = bb_color;
+			}
+		}
+
+		/*
+		* Records the draws of the visible entities into the command lists of
+		* `frame` (camera already filled), slices of entities are recorded in
+		* parallel.
+		*/
+		void buildCommands(dlb::RenderSnapshot& frame) {
+			PROFILE_ZONE("EntityPool::buildCommands");
+
+			auto& context = dlb::ApplicationSingleton::getInstance();
+			const auto frustum = scene::Frustum::fromMatrix(frame.projection * frame.view);
+			const auto view = frame.view;
+			const float z_far = frame.z_far;
+
+			frame.commands.build(entities_.size(), [&](dlb::CommandList& list, uint begin, uint end) {
+				for (uint i = begin; i < end; i++) {
+					const auto& entity = entities_[i];
+
+					if (entity.dead)
+						continue;
+
+					const auto& comp = components_[entity.id];
+					const auto& model = context.getModel(entity.model_id);
+					const auto& aabb = model.getAABB();
+
+					glm::mat4 transform = glm::translate(glm::mat4(1.0F), comp.movement.position);
+
+					if (!frustum.intersects(aabb.min, aabb.max, transform))
+						continue;
+
+					float depth = -(view * transform[3]).z / z_far;
+
+					list.push(dlb::makeSortKey(dlb::RenderPass::Opaque, entity.shader_id, entity.model_id, depth), {
+						.type = dlb::RenderCommandType::DrawModel,
+						.shader_id = entity.shader_id,
+						.model_id = entity.model_id,
+						.transform = transform,
+					});
+				}
+			});
+		}
+
+		/*
+		* World-space bounding boxes of the entities whose model has
+		* ModelFlags::DrawAABB, red when colliding.
+		*/
+		void drawDebug(dlb::DebugDraw& debug) {
+			PROFILE_ZONE("EntityPool::drawDebug");
+
+			auto& context = dlb::ApplicationSingleton::getInstance();
+
+			debug.clear();
+
+			for (const auto& entity : entities_) {
+				if (entity.dead)
+					continue;
+
+				const auto& model = context.getModel(entity.model_id);
+
+				if (!(model.getFlags() & scene::ModelFlags::DrawAABB))
+					continue;
 
-				auto trans = glm::mat4(1.0F);
-				trans = glm::translate(trans, mov.position);
+				const auto& comp = components_[entity.id];
+				const auto& aabb = model.getAABB();
 
-				model.draw(context.getShader(entity.shader_id), trans, bb_color);
+				debug.box(aabb.min + comp.movement.position, aabb.max + comp.movement.position, glm::vec4(comp.debug.bb_color, 0.5f));
 			}
 		}
 
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+#include "Types.hpp"
+#include "ecs/ECS.hpp"
+
+namespace ecs {
+
+	/*
+	* ImGui entity list that stays cheap at any scene size: the rows matching
+	* the search/filters are indexed at most every `refresh_interval_`
+	* seconds, only the visible rows are drawn (ImGuiListClipper) and labels
+	* are formatted into stack buffers, so a frame does not allocate.
+	*/
+	class EntityInspector {
+	public:
+		EntityInspector() {}
+
+	public:
+		void draw(const EntityPool& pool);
+
+		void setRefreshInterval(double seconds) {
+			refresh_interval_ = seconds;
+		}
+
+	private:
+		void rebuildIndex(const EntityPool& pool);
+		bool matches(const EntityPool& pool, const Entity& entity) const;
+		void drawDetails(const EntityPool& pool);
+
+	private:
+		// ids of the entities shown, in id order
+		std::vector<uint> rows_;
+
+		char search_[32] = {};
+		bool colliding_only_ = false;
+		int model_filter_ = -1;
+
+		int selected_ = -1;
+
+		double refresh_interval_ = 0.25;
+		u64 last_refresh_ns_ = 0;
+		bool dirty_ = true;
+	};
+}
@@ -1,11 +1,90 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+#include <cstddef>
+
+#include "io/MappedFile.hpp"
+
 namespace dlb {
-	class FileReader {
+	enum class FileError {
+		None,
+		NotFound,
+		// empty, can not be mapped or a corrupt pack entry
+		Unreadable,
+	};
+
+	const char* fileErrorString(FileError error);
+
+	/*
+	* Read-only view of a whole file, mapped from disk or borrowed from the
+	* resource pack (see VirtualFileSystem), released when destroyed. Nothing
+	* is copied unless the pack entry was compressed.
+	*/
+	class FileView {
 	public:
-		FileReader() {
+		FileView() {}
+
+		FileView(const FileView&) = delete;
+		FileView(FileView&&) noexcept = default;
+		FileView& operator=(FileView&&) noexcept = default;
+
+	public:
+		explicit operator bool() const {
+			return error_ == FileError::None && file_.isOpen();
+		}
+
+		FileError error() const {
+			return error_;
+		}
+
+		const unsigned char* data() const {
+			return file_.data();
+		}
+
+		size_t size() const {
+			return file_.size();
+		}
+
+		std::span<const std::byte> bytes() const {
+			return { (const std::byte*)file_.data(), file_.size() };
+		}
+
+		std::string_view text() const {
+			return { (const char*)file_.data(), file_.size() };
+		}
 
+		void close() {
+			file_.close();
 		}
 
+		/*
+		* Asks the OS to read the pages in the background, see FileReader::openBatch.
+		*/
+		void prefetch() const {
+			file_.prefetch();
+		}
+
+	private:
+		friend class FileReader;
+
+		MappedFile file_;
+		FileError error_ = FileError::NotFound;
+	};
+
+	class FileReader {
 	public:
-		static std::string read(const std::string& path);
+		/*
+		* `path` is a logical `res://` path or a plain file system path, any thread.
+		*/
+		static FileView open(const std::string& path);
+
+		/*
+		* Opens every file on the thread pool and starts reading all of them
+		* in at once, the views come back in the order of `paths`.
+		*/
+		static std::vector<FileView> openBatch(std::span<const std::string> paths);
 	};
-}
\ No newline at end of file
+}
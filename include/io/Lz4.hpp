@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+namespace dlb {
+
+	/*
+	* LZ4 block format (no frame), used for the compressed entries of the
+	* resource pack. Decompression is a few bytes of bookkeeping per copy,
+	* fast enough to run while loading.
+	*/
+	constexpr size_t lz4CompressBound(size_t size) {
+		return size + size / 255 + 16;
+	}
+
+	/*
+	* Greedy single pass compressor, returns the compressed size or 0 when
+	* the result does not fit in `capacity`.
+	*/
+	size_t lz4Compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity);
+
+	/*
+	* Returns false when `src` is corrupt or does not decompress to exactly
+	* `dst_size` bytes, never reads or writes out of bounds.
+	*/
+	bool lz4Decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t dst_size);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace dlb {
+
+	/*
+	* Read-only memory mapping of a whole file, the pages are loaded by the
+	* OS on first access and nothing is copied. Entries of a resource pack
+	* are handed out as borrowed ranges of the pack mapping, or as owned
+	* bytes when they were compressed (see dlb::VirtualFileSystem).
+	*/
+	class MappedFile {
+	public:
+		MappedFile() {}
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& x) noexcept;
+		MappedFile& operator=(MappedFile&& x) noexcept;
+
+	public:
+		/*
+		* Returns false (and logs) when the file can not be opened or is empty.
+		*/
+		bool open(const std::string& path);
+		void close();
+
+		/*
+		* Starts reading the pages in the background (MADV_WILLNEED /
+		* PrefetchVirtualMemory), no-op for adopted memory.
+		*/
+		void prefetch() const;
+
+		/*
+		* Points at memory that outlives this object, close() only forgets it.
+		*/
+		void borrow(const unsigned char* data, size_t size);
+
+		/*
+		* Takes `bytes`, close() frees them.
+		*/
+		void adopt(std::vector<unsigned char>&& bytes);
+
+		bool isOpen() const {
+			return data_ != nullptr;
+		}
+
+		const unsigned char* data() const {
+			return data_;
+		}
+
+		size_t size() const {
+			return size_;
+		}
+
+	private:
+		const unsigned char* data_ = nullptr;
+		size_t size_ = 0;
+		// false for borrowed and adopted memory
+		bool mapped_ = false;
+		std::vector<unsigned char> storage_;
+
+#ifdef _WIN32
+		void* file_ = nullptr;
+		void* mapping_ = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string_view>
+
+#include "Types.hpp"
+
+namespace dlb {
+
+	/*
+	* .dlbp resource pack (little endian): PackHeader, the data of every
+	* entry at a PACK_ALIGNMENT aligned offset, then the index (PackEntry
+	* sorted by hash, equal hashes by path) and the string blob holding the
+	* logical paths. Stored entries keep the alignment a .dlbm or KTX2 file
+	* needs, so they are used in place.
+	*/
+	constexpr char PACK_FILE_MAGIC[4] = { 'D', 'L', 'B', 'P' };
+	constexpr uint PACK_FILE_VERSION = 1;
+	constexpr const char* PACK_FILE_EXTENSION = ".dlbp";
+	constexpr u64 PACK_ALIGNMENT = 16;
+
+	enum PackEntryFlags : uint {
+		// LZ4 block, `stored_size` bytes decompress to `size`
+		PackLz4 = 1 << 0,
+	};
+
+	struct PackHeader {
+		char magic[4];
+		uint version;
+		uint entry_count;
+		uint reserved;
+		u64 index_offset;
+		u64 strings_offset;
+		u64 strings_size;
+	};
+
+	struct PackEntry {
+		u64 hash;
+		u64 offset;
+		u64 size;
+		u64 stored_size;
+		// logical path without the scheme, a range of the string blob
+		uint path_offset;
+		uint path_length;
+		uint flags;
+		uint reserved;
+	};
+
+	static_assert(sizeof(PackHeader) == 40, "pack header layout");
+	static_assert(sizeof(PackEntry) == 48, "pack entry layout");
+
+	/*
+	* FNV-1a of the normalized logical path ("models/tree/tree.obj").
+	*/
+	constexpr u64 hashPackPath(std::string_view path) {
+		u64 hash = 0xCBF29CE484222325ull;
+
+		for (char c : path)
+			hash = (hash ^ (unsigned char)c) * 0x100000001B3ull;
+
+		return hash;
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "Types.hpp"
+#include "io/MappedFile.hpp"
+#include "io/PackFile.hpp"
+
+namespace dlb {
+
+	/*
+	* Resolves logical resource paths (`res://models/tree/tree.obj`) against
+	* a mounted .dlbp pack first and the loose resource directory second.
+	* Paths without the scheme are plain file system paths and pass through,
+	* so tools that never mount anything keep working.
+	*
+	* Mount before the first load, lookups are read only afterwards and run
+	* on any thread.
+	*/
+	class VirtualFileSystem {
+	public:
+		static constexpr std::string_view SCHEME = "res://";
+
+		static VirtualFileSystem& getInstance() {
+			static VirtualFileSystem instance{};
+			return instance;
+		}
+
+		VirtualFileSystem(const VirtualFileSystem&) = delete;
+
+	public:
+		/*
+		* Directory the logical paths map to when the pack does not have
+		* them, also where caches next to a resource are written.
+		*/
+		void mountDirectory(const std::string& root);
+
+		/*
+		* Maps the pack once, returns false (and logs) when it is not a
+		* valid pack. Mounting again replaces it.
+		*/
+		bool mountPack(const std::string& path);
+
+		static bool isLogical(std::string_view path) {
+			return path.starts_with(SCHEME);
+		}
+
+		/*
+		* `res://a/./b\\c.png` -> `a/b/c.png`, the key of a pack entry.
+		*/
+		static std::string normalize(std::string_view path);
+
+		/*
+		* File system path of a logical path in the loose directory, plain
+		* paths are returned as they are.
+		*/
+		std::string resolve(const std::string& path) const;
+
+		/*
+		* Whether the mounted pack holds `path`, packed files are never out of date.
+		*/
+		bool isPacked(const std::string& path) const;
+
+		bool exists(const std::string& path) const;
+
+		/*
+		* A packed entry is borrowed from the pack mapping (or decompressed),
+		* anything else is mapped from the file system. Returns false without
+		* logging when the file does not exist.
+		*/
+		bool open(const std::string& path, MappedFile& file) const;
+
+		u64 getPackedCount() const {
+			return entries_ ? header_.entry_count : 0;
+		}
+
+	private:
+		VirtualFileSystem() {}
+
+		const PackEntry* find(const std::string& path) const;
+
+	private:
+		std::string root_;
+
+		MappedFile pack_;
+		PackHeader header_{};
+		// point into pack_
+		const PackEntry* entries_ = nullptr;
+		const char* strings_ = nullptr;
+	};
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+#include "Types.hpp"
+
+namespace dlb {
+
+	/*
+	* Fixed-size pool of worker threads shared by the whole engine.
+	* Jobs never touch GL, everything that needs the context is queued back to
+	* the GL thread by the caller.
+	*/
+	class ThreadPool {
+	private:
+		ThreadPool(uint workers);
+
+	public:
+		~ThreadPool();
+
+		// hardware_concurrency() may be 0 when unknown
+		static ThreadPool& getInstance() {
+			static ThreadPool pool{ std::max(2u, std::thread::hardware_concurrency()) - 1 };
+			return pool;
+		}
+
+	public:
+		uint workerCount() const {
+			return workers_.size();
+		}
+
+		/*
+		* Queues `fn` and returns a future with its result.
+		*/
+		template<typename F>
+		auto submit(F&& fn) -> std::future<decltype(fn())> {
+			using R = decltype(fn());
+
+			auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+			auto future = task->get_future();
+
+			push([task] { (*task)(); });
+
+			return future;
+		}
+
+		/*
+		* Splits [0, count) in chunks of at least `grain` items and runs
+		* `fn(begin, end)` on every chunk. The calling thread takes part in the
+		* work, only ever running chunks of this call, and the call returns
+		* once every chunk is done.
+		*/
+		void parallelFor(uint count, uint grain, const std::function<void(uint, uint)>& fn);
+
+		/*
+		* Runs one queued job on the calling thread, returns false when the
+		* queue is empty. Used to help instead of blocking while waiting.
+		*/
+		bool runPending();
+
+	private:
+		void push(std::function<void()>&& job);
+		void workerLoop();
+
+	private:
+		std::vector<std::thread> workers_;
+		std::deque<std::function<void()>> jobs_;
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		bool stop_ = false;
+	};
+}
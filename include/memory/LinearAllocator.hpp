@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <new>
+#include <algorithm>
+#include <type_traits>
+
+namespace dlb {
+
+	/*
+	* Bump allocator for per-frame data, freed all at once with reset().
+	* Blocks are kept across resets so a steady workload stops allocating
+	* after the first frames. Only trivially destructible types, nothing is
+	* ever destroyed.
+	*/
+	class LinearAllocator {
+	public:
+		static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+		LinearAllocator() {}
+
+		LinearAllocator(const LinearAllocator&) = delete;
+
+	public:
+		void* allocate(size_t size, size_t align) {
+			for (;;) {
+				if (block_ < blocks_.size()) {
+					auto& block = blocks_[block_];
+					size_t offset = (offset_ + align - 1) & ~(align - 1);
+
+					if (offset + size <= block.size) {
+						offset_ = offset + size;
+						return block.data.get() + offset;
+					}
+
+					block_++;
+					offset_ = 0;
+					continue;
+				}
+
+				size_t block_size = std::max(BLOCK_SIZE, size + align);
+				blocks_.push_back({ std::make_unique<std::byte[]>(block_size), block_size });
+			}
+		}
+
+		template<typename T, typename... Args>
+		T* make(Args&&... args) {
+			static_assert(std::is_trivially_destructible_v<T>, "LinearAllocator never runs destructors.");
+			return new (allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+		}
+
+		void reset() {
+			block_ = 0;
+			offset_ = 0;
+		}
+
+	private:
+		struct Block {
+			std::unique_ptr<std::byte[]> data;
+			size_t size;
+		};
+
+		std::vector<Block> blocks_;
+		size_t block_ = 0;
+		size_t offset_ = 0;
+	};
+}
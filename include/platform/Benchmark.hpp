@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include <glad/glad.h>
+
+namespace dlb {
+
+	/*
+	* Records the CPU time and the GPU time (GL_TIME_ELAPSED) of every frame.
+	* GPU results are read QUERY_LATENCY frames later so recording never stalls
+	* the pipeline.
+	*/
+	class BenchmarkRecorder {
+	public:
+		static constexpr int QUERY_LATENCY = 4;
+
+		BenchmarkRecorder() {}
+		~BenchmarkRecorder();
+
+		BenchmarkRecorder(const BenchmarkRecorder&) = delete;
+
+	public:
+		void beginFrame();
+		void endFrame();
+
+		/*
+		* Collects the pending GPU results and writes `frame,cpu_ms,gpu_ms` rows.
+		*/
+		bool writeCSV(const std::string& path);
+
+		void printSummary();
+
+	private:
+		void collect(bool wait);
+
+	private:
+		struct FrameTiming {
+			double cpu_ms = 0.0;
+			double gpu_ms = -1.0;
+		};
+
+		std::vector<FrameTiming> frames_;
+
+		GLuint queries_[QUERY_LATENCY] = {};
+		// frame index measured by each query, -1 when free
+		long long query_frame_[QUERY_LATENCY] = { -1, -1, -1, -1 };
+
+		std::chrono::steady_clock::time_point frame_start_;
+	};
+}
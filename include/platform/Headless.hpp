@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace dlb {
+
+	/*
+	* GL 3.3 core context without a window (EGL surfaceless, Mesa llvmpipe
+	* works too) that renders into an offscreen framebuffer. Only available when
+	* built with LEARNOPENGL_HEADLESS, otherwise create() always fails.
+	*/
+	class HeadlessContext {
+	public:
+		HeadlessContext() {}
+		~HeadlessContext();
+
+		HeadlessContext(const HeadlessContext&) = delete;
+
+	public:
+		/*
+		* Creates the context and makes it current, GL functions can be
+		* loaded with getProcAddress afterwards.
+		*/
+		bool create();
+
+		/*
+		* Creates and binds the RGBA8 + depth framebuffer every frame renders to.
+		*/
+		void createFramebuffer(int width, int height);
+
+		/*
+		* Deletes the framebuffer, the context must be current.
+		*/
+		void destroyFramebuffer();
+
+		static void* getProcAddress(const char* name);
+
+		/*
+		* Binds the context to the calling thread, or unbinds it so another
+		* thread (the render thread) can take it.
+		*/
+		bool makeCurrent(bool current);
+
+		/*
+		* Writes the framebuffer as a binary PPM, for image-regression runs.
+		*/
+		bool writePPM(const std::string& path) const;
+
+	private:
+		void* display_ = nullptr;
+		void* context_ = nullptr;
+
+		GLuint fbo_ = 0, color_ = 0, depth_ = 0;
+		int width_ = 0, height_ = 0;
+	};
+}
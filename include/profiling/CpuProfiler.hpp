@@ -0,0 +1,175 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "Types.hpp"
+
+/*
+* Scoped CPU zone, `name` must be a string literal:
+*	PROFILE_ZONE("Model::draw");
+*/
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ::dlb::ScopedCpuZone PROFILE_CONCAT(profile_zone_, __LINE__){ name }
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+
+namespace dlb {
+
+	/*
+	* Profiler clock: RDTSC on x86, steady_clock elsewhere. Ticks are converted
+	* to nanoseconds with CpuProfiler::ticksToNs.
+	*/
+	inline u64 profilerTicks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	struct CpuZoneEvent {
+		const char* name;
+		u64 begin;
+		u64 end;
+		uint depth;
+	};
+
+	/*
+	* Single-producer ring of finished zones. Only the owning thread writes,
+	* the profiler reads from the main thread without locks: `head` is
+	* published with release ordering and events older than
+	* `head - CAPACITY` are considered overwritten.
+	*/
+	struct CpuZoneBuffer {
+		static constexpr uint CAPACITY = 1 << 16;
+
+		CpuZoneEvent events[CAPACITY];
+		std::atomic<u64> head{ 0 };
+		u64 tail = 0;
+
+		uint thread_index = 0;
+		uint depth = 0;
+
+		void push(const CpuZoneEvent& event) {
+			u64 h = head.load(std::memory_order_relaxed);
+			events[h % CAPACITY] = event;
+			head.store(h + 1, std::memory_order_release);
+		}
+	};
+
+	class CpuProfiler {
+	private:
+		CpuProfiler();
+
+	public:
+		static CpuProfiler& getInstance() {
+			static CpuProfiler profiler{};
+			return profiler;
+		}
+
+		/*
+		* Buffer of the calling thread, registered on first use.
+		*/
+		static CpuZoneBuffer& threadBuffer();
+
+	public:
+		/*
+		* Marks the frame boundaries, the flame graph shows the last complete frame.
+		*/
+		void beginFrame();
+		void endFrame();
+
+		/*
+		* Drains every thread buffer, called once per frame on the main thread.
+		*/
+		void collect();
+
+		/*
+		* While recording, every collected zone is kept for the Chrome trace.
+		*/
+		void setRecording(bool value);
+
+		bool isRecording() const {
+			return recording_;
+		}
+
+		/*
+		* Chrome trace_event JSON (chrome://tracing, Perfetto).
+		*/
+		bool writeChromeTrace(const std::string& path);
+
+		void drawImGui();
+
+		/*
+		* Longest top-level zone of the last frame on `thread_index`, followed
+		* down while one child takes most of its parent, e.g.
+		* "EntityPool::iterate > Model::draw". Empty when nothing was recorded.
+		*/
+		std::string hotPath(uint thread_index) const;
+
+		double ticksToNs(u64 ticks) const;
+
+	private:
+		CpuZoneBuffer& registerThread();
+
+	private:
+		struct ThreadZone {
+			CpuZoneEvent event;
+			uint thread_index;
+		};
+
+		std::mutex registry_mutex_;
+		std::vector<std::unique_ptr<CpuZoneBuffer>> buffers_;
+
+		// zones of the frame being built and of the last complete frame
+		std::vector<ThreadZone> current_frame_;
+		std::vector<ThreadZone> last_frame_;
+		u64 frame_begin_ = 0, frame_end_ = 0;
+		u64 last_frame_begin_ = 0, last_frame_end_ = 0;
+
+		std::vector<ThreadZone> recorded_;
+		bool recording_ = false;
+
+		// clock calibration points
+		u64 ticks0_;
+		std::chrono::steady_clock::time_point time0_;
+
+		static constexpr size_t MAX_RECORDED = 1 << 21;
+	};
+
+	class ScopedCpuZone {
+	public:
+		ScopedCpuZone(const char* name)
+			:buffer_(CpuProfiler::threadBuffer()),
+			name_(name) {
+			depth_ = buffer_.depth++;
+			begin_ = profilerTicks();
+		}
+
+		~ScopedCpuZone() {
+			u64 end = profilerTicks();
+			buffer_.depth--;
+			buffer_.push({ name_, begin_, end, depth_ });
+		}
+
+		ScopedCpuZone(const ScopedCpuZone&) = delete;
+
+	private:
+		CpuZoneBuffer& buffer_;
+		const char* name_;
+		u64 begin_;
+		uint depth_;
+	};
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <atomic>
+
+#include "Types.hpp"
+
+namespace dlb {
+
+	enum class FramePhase {
+		Simulation = 0,
+		RenderSubmit,
+		Swap,
+		Count
+	};
+
+	/*
+	* Frame timing service: per-frame CPU time split into phases, a rolling
+	* history for percentiles and hitch detection, and session statistics
+	* dumped on exit.
+	*/
+	class FrameStats {
+	private:
+		FrameStats() {}
+
+	public:
+		static constexpr uint HISTORY = 1024;
+		static constexpr uint MAX_HITCHES = 64;
+		static constexpr uint PHASE_COUNT = (uint)FramePhase::Count;
+
+		static FrameStats& getInstance() {
+			static FrameStats stats{};
+			return stats;
+		}
+
+		/*
+		* Monotonic clock in nanoseconds
+		*/
+		static u64 nowNs() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		static const char* phaseName(FramePhase phase);
+
+	public:
+		void beginFrame();
+
+		/*
+		* Closes the frame, must be called after the CPU profiler ended its
+		* frame so a hitch can be attributed to a zone.
+		*/
+		void endFrame();
+
+		/*
+		* Adds time to a phase of the current frame. A phase may be entered
+		* several times per frame and from the render thread, the times add up.
+		*/
+		void addPhase(FramePhase phase, u64 ns) {
+			phase_ns_[(uint)phase].fetch_add(ns, std::memory_order_relaxed);
+		}
+
+		void setHitchThreshold(double ms) {
+			hitch_threshold_ms_ = ms;
+		}
+
+		double getHitchThreshold() const {
+			return hitch_threshold_ms_;
+		}
+
+		/*
+		* Over the rolling history, `phase` Count is the whole frame.
+		*/
+		double percentile(FramePhase phase, float p) const;
+		double worst(FramePhase phase) const;
+
+		double averageFrameMs() const;
+
+		u64 getFrameIndex() const {
+			return frame_index_;
+		}
+
+		void drawImGui();
+
+		/*
+		* Whole-session percentiles, worst frame and hitches.
+		*/
+		void printSummary() const;
+		bool writeSummary(const std::string& path) const;
+
+	private:
+		struct FrameSample {
+			// Frame, then one entry per phase
+			float ms[PHASE_COUNT + 1] = {};
+		};
+
+		struct Hitch {
+			u64 frame;
+			float ms;
+			FramePhase phase;
+			std::string zone;
+		};
+
+		std::string summary() const;
+
+	private:
+		std::array<FrameSample, HISTORY> history_{};
+		uint head_ = 0, count_ = 0;
+
+		// every frame of the session, for the exit report
+		std::vector<FrameSample> session_;
+
+		std::vector<Hitch> hitches_;
+		u64 hitch_count_ = 0;
+		double hitch_threshold_ms_ = 33.3;
+
+		u64 frame_index_ = 0;
+		u64 frame_begin_ = 0;
+		std::atomic<u64> phase_ns_[PHASE_COUNT] = {};
+	};
+
+	class ScopedFramePhase {
+	public:
+		ScopedFramePhase(FramePhase phase)
+			:phase_(phase),
+			begin_(FrameStats::nowNs()) {
+		}
+
+		~ScopedFramePhase() {
+			FrameStats::getInstance().addPhase(phase_, FrameStats::nowNs() - begin_);
+		}
+
+		ScopedFramePhase(const ScopedFramePhase&) = delete;
+
+	private:
+		FramePhase phase_;
+		u64 begin_;
+	};
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+#include <glad/glad.h>
+
+#include "Types.hpp"
+
+namespace dlb {
+
+	/*
+	* GPU timings of named render passes.
+	* Passes are delimited by GL_TIMESTAMP queries (so they can nest) taken
+	*	from a ring of FRAME_LATENCY frames, a frame is read back when its slot
+	*	comes around again so the CPU never waits for the GPU.
+	* Pass names must be string literals, they are looked up by address.
+	* Passes are recorded on the render thread, the statistics are guarded
+	*	so drawImGui can run on the simulation thread.
+	*/
+	class GpuProfiler {
+	public:
+		static constexpr int FRAME_LATENCY = 4;
+		static constexpr int MAX_PASSES = 32;
+		static constexpr int HISTORY = 256;
+
+	private:
+		GpuProfiler() {}
+
+	public:
+		static GpuProfiler& getInstance() {
+			static GpuProfiler profiler{};
+			return profiler;
+		}
+
+		struct PassStats {
+			const char* name;
+			// ring of the last HISTORY samples in ms and the frame each one belongs to
+			float samples[HISTORY];
+			u64 frames[HISTORY];
+			uint count = 0;
+			uint head = 0;
+
+			float average() const;
+		};
+
+	public:
+		void setEnabled(bool value) {
+			enabled_ = value;
+		}
+
+		void beginFrame();
+		void endFrame();
+
+		/*
+		* `name` must outlive the profiler (a string literal), passes with the
+		*	same name share one row wherever they are started.
+		*/
+		void beginPass(const char* name);
+		void endPass();
+
+		const std::vector<PassStats>& getPasses() const {
+			return passes_;
+		}
+
+		/*
+		* Percentile `p` (0..1) of the recorded history of `pass`.
+		*/
+		float percentile(const PassStats& pass, float p);
+
+		/*
+		* Table with the average and percentiles of every pass.
+		*/
+		void drawImGui();
+
+		/*
+		* Writes the recorded history as `frame,pass,ms` rows.
+		*/
+		bool writeCSV(const std::string& path) const;
+
+	private:
+		int passId(const char* name);
+		void resolve(int slot);
+
+	private:
+		struct FrameQueries {
+			GLuint queries[MAX_PASSES * 2] = {};
+			int pass_ids[MAX_PASSES];
+			int pass_count = 0;
+			u64 frame = 0;
+			bool pending = false;
+		};
+
+		FrameQueries frames_[FRAME_LATENCY];
+		int current_slot_ = 0;
+		u64 frame_ = 0;
+
+		// query index of every open pass
+		std::vector<int> stack_;
+
+		std::vector<PassStats> passes_;
+		// keyed on the contents, the same literal may have several addresses
+		std::unordered_map<std::string_view, int> ids_;
+
+		std::vector<float> scratch_;
+		mutable std::mutex stats_mutex_;
+		bool enabled_ = true;
+		bool initialized_ = false;
+	};
+
+	/*
+	* Times the enclosing scope as a GpuProfiler pass.
+	*/
+	class ScopedGpuPass {
+	public:
+		ScopedGpuPass(const char* name) {
+			GpuProfiler::getInstance().beginPass(name);
+		}
+
+		~ScopedGpuPass() {
+			GpuProfiler::getInstance().endPass();
+		}
+
+		ScopedGpuPass(const ScopedGpuPass&) = delete;
+	};
+}
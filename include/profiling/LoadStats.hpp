@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+#include "Types.hpp"
+
+namespace dlb {
+
+	enum class LoadPhase {
+		// window, GL context and loader
+		Context = 0,
+		// source reading, preprocessing and compile submission
+		ShaderCompile,
+		// link, status checks and program binary cache
+		ShaderLink,
+		// cooked file, import cache entry or assimp
+		ModelImport,
+		// image decoding or KTX2 mapping and compression
+		TextureDecode,
+		TextureUpload,
+		// vertex, index and material buffers
+		BufferUpload,
+		Count
+	};
+
+	/*
+	* Startup instrumentation: every load step is timed and attributed to a
+	* phase and a name (a path or a program), with the bytes it read and
+	* uploaded. Steps with the same phase and name add up, a model uploaded
+	* over several frames is one entry. finishStartup() prints the report
+	* sorted by time and writes it as JSON, recording stops afterwards.
+	*
+	* Any thread. The times are per step, steps on the thread pool overlap so
+	* the phase totals can exceed the wall clock time.
+	*/
+	class LoadStats {
+	private:
+		LoadStats() {}
+
+	public:
+		static constexpr uint PHASE_COUNT = (uint)LoadPhase::Count;
+
+		static LoadStats& getInstance() {
+			static LoadStats stats{};
+			return stats;
+		}
+
+		static const char* phaseName(LoadPhase phase);
+
+	public:
+		void record(LoadPhase phase, std::string_view name, u64 ns, u64 bytes_read, u64 bytes_uploaded);
+
+		bool isRecording() const {
+			return !finished_.load(std::memory_order_relaxed);
+		}
+
+		/*
+		* End of startup: prints the report and writes the JSON to `json_path`
+		* unless it is empty. Only the first call reports.
+		*/
+		void finishStartup(const std::string& json_path);
+
+		std::string report() const;
+		bool writeJson(const std::string& path) const;
+
+	private:
+		struct Item {
+			LoadPhase phase;
+			std::string name;
+			uint count = 0;
+			u64 ns = 0;
+			u64 bytes_read = 0;
+			u64 bytes_uploaded = 0;
+		};
+
+		// items by time, slowest first
+		std::vector<Item> sorted() const;
+		// one item per phase
+		std::vector<Item> phaseTotals(const std::vector<Item>& items) const;
+
+	private:
+		mutable std::mutex mutex_;
+		std::vector<Item> items_;
+		// (phase, name) -> index in items_
+		std::map<std::pair<uint, std::string>, size_t> index_;
+
+		std::atomic<bool> finished_{ false };
+		// process start to finishStartup
+		u64 startup_ns_ = 0;
+	};
+
+	/*
+	* Records the scope as one step of `phase`, `name` must outlive it:
+	*	ScopedLoadTimer timer{ LoadPhase::TextureDecode, path };
+	*	timer.addBytesRead(file.size());
+	*/
+	class ScopedLoadTimer {
+	public:
+		ScopedLoadTimer(LoadPhase phase, std::string_view name);
+		~ScopedLoadTimer();
+
+		ScopedLoadTimer(const ScopedLoadTimer&) = delete;
+
+		void addBytesRead(u64 bytes) {
+			bytes_read_ += bytes;
+		}
+
+		void addBytesUploaded(u64 bytes) {
+			bytes_uploaded_ += bytes;
+		}
+
+	private:
+		LoadPhase phase_;
+		std::string_view name_;
+		u64 begin_;
+		u64 bytes_read_ = 0;
+		u64 bytes_uploaded_ = 0;
+	};
+}
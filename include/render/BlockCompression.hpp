@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include "Types.hpp"
+#include "io/FileReader.hpp"
+
+namespace dlb {
+
+	/*
+	* Block compressed formats, 4x4 texels per block.
+	*/
+	enum class BlockFormat : uint {
+		// RGB, 8 bytes per block
+		BC1,
+		// RGBA, BC1 colour plus an interpolated alpha block, 16 bytes per block
+		BC3,
+		// two interpolated channels (tangent space normal XY), 16 bytes per block
+		BC5,
+	};
+
+	constexpr uint blockBytes(BlockFormat format) {
+		return format == BlockFormat::BC1 ? 8 : 16;
+	}
+
+	constexpr size_t compressedLevelBytes(BlockFormat format, int width, int height) {
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+	}
+
+	/*
+	* A full mip chain of block compressed data, the levels point either
+	* into `storage` or into a mapped cache file.
+	*/
+	struct CompressedImage {
+		BlockFormat format = BlockFormat::BC1;
+		int width = 0;
+		int height = 0;
+		// level 0 first
+		std::vector<std::span<const unsigned char>> levels;
+
+		std::vector<unsigned char> storage;
+		FileView file;
+
+		bool empty() const {
+			return levels.empty();
+		}
+
+		size_t bytes() const {
+			size_t total = 0;
+
+			for (const auto& level : levels)
+				total += level.size();
+
+			return total;
+		}
+	};
+
+	/*
+	* BC1 unless a texel is not fully opaque, then BC3.
+	*/
+	BlockFormat chooseBlockFormat(const unsigned char* rgba, int width, int height);
+
+	/*
+	* Builds the mip chain of the RGBA8 image (box filter) and compresses
+	* every level on the thread pool. No GL, any thread.
+	*/
+	CompressedImage compressImage(const unsigned char* rgba, int width, int height, BlockFormat format);
+
+	/*
+	* Single blocks, `rgba` holds the 16 texels of the block row by row.
+	*/
+	void compressBlockBC1(const unsigned char* rgba, unsigned char* out);
+	void compressBlockBC3(const unsigned char* rgba, unsigned char* out);
+	void compressBlockBC5(const unsigned char* rgba, unsigned char* out);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <atomic>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "Types.hpp"
+#include "memory/LinearAllocator.hpp"
+
+namespace dlb {
+
+	/*
+	* Passes in submission order, the pass is the top of the sort key.
+	*/
+	enum class RenderPass {
+		Opaque = 0,
+	};
+
+	enum class RenderCommandType {
+		DrawModel,
+	};
+
+	/*
+	* API-agnostic draw, replayed by the GL thread.
+	*/
+	struct RenderCommand {
+		RenderCommandType type;
+		uint shader_id;
+		uint model_id;
+		glm::mat4 transform;
+	};
+
+	struct RenderCommandKey {
+		u64 key;
+		const RenderCommand* command;
+	};
+
+	/*
+	* 2 bits pass | 16 bits shader | 16 bits model | 30 bits depth, so a pass
+	* is drawn shader by shader, model by model, front to back.
+	*/
+	inline u64 makeSortKey(RenderPass pass, uint shader_id, uint model_id, float depth01) {
+		u64 depth = (u64)(glm::clamp(depth01, 0.0f, 1.0f) * ((1u << 30) - 1));
+
+		return ((u64)pass << 62)
+			| ((u64)(shader_id & 0xFFFF) << 46)
+			| ((u64)(model_id & 0xFFFF) << 30)
+			| depth;
+	}
+
+	/*
+	* Commands recorded by one job into its own linear memory.
+	*/
+	class CommandList {
+	public:
+		void reset() {
+			allocator_.reset();
+			keys_.clear();
+		}
+
+		void push(u64 key, const RenderCommand& command) {
+			keys_.push_back({ key, allocator_.make<RenderCommand>(command) });
+		}
+
+		const std::vector<RenderCommandKey>& getKeys() const {
+			return keys_;
+		}
+
+	private:
+		LinearAllocator allocator_;
+		std::vector<RenderCommandKey> keys_;
+	};
+
+	/*
+	* The command lists of a frame: built in parallel on the thread pool,
+	* merged into one sorted key array, then replayed on the GL thread
+	* without allocating.
+	*/
+	class CommandBuffer {
+	public:
+		static constexpr uint GRAIN = 256;
+
+		using BuildFn = std::function<void(CommandList& list, uint begin, uint end)>;
+
+		/*
+		* Runs `fn` over [0, count) in parallel, every job records into its
+		* own list, then merges and sorts.
+		*/
+		void build(uint count, const BuildFn& fn);
+
+		const std::vector<RenderCommandKey>& getSorted() const {
+			return sorted_;
+		}
+
+		/*
+		* Sorted commands of one pass.
+		*/
+		std::span<const RenderCommandKey> getPass(RenderPass pass) const;
+
+	private:
+		std::vector<std::unique_ptr<CommandList>> lists_;
+		std::vector<RenderCommandKey> sorted_;
+	};
+}
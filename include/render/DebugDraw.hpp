@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Types.hpp"
+#include "ShaderProgram.hpp"
+#include "render/VertexLayout.hpp"
+
+namespace dlb {
+
+	struct DebugVertex {
+		glm::vec3 position;
+		// RGBA8
+		unsigned int color;
+
+		static constexpr auto attributes();
+	};
+
+	// matches the inputs of Debug.vert
+	constexpr auto DebugVertex::attributes() {
+		return std::array{
+			VertexAttribute{ 0, VertexFormat::Float3, offsetof(DebugVertex, position), "a_pos" },
+			VertexAttribute{ 1, VertexFormat::UByte4Norm, offsetof(DebugVertex, color), "a_color" },
+		};
+	}
+
+	static_assert(sizeof(DebugVertex) == 16, "DebugVertex must be 16 bytes.");
+
+	/*
+	* Immediate-mode debug primitives of one frame. Every primitive is
+	* expanded to world-space line segments when it is added, so the whole
+	* frame is drawn by DebugRenderer with a single GL_LINES call.
+	*/
+	class DebugDraw {
+	public:
+		static constexpr uint SPHERE_SEGMENTS = 16;
+
+		void clear() {
+			vertices_.clear();
+		}
+
+		void line(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color);
+
+		/*
+		* Axis-aligned world-space box.
+		*/
+		void box(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color);
+
+		/*
+		* Local box `min`-`max` transformed by `transform`, rotations included.
+		*/
+		void box(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform, const glm::vec4& color);
+
+		/*
+		* Three great circles.
+		*/
+		void sphere(const glm::vec3& center, float radius, const glm::vec4& color);
+
+		/*
+		* Edges of the frustum of `view_projection`.
+		*/
+		void frustum(const glm::mat4& view_projection, const glm::vec4& color);
+
+		const std::vector<DebugVertex>& getVertices() const {
+			return vertices_;
+		}
+
+	private:
+		void boxCorners(const glm::vec3 corners[8], unsigned int color);
+
+	private:
+		std::vector<DebugVertex> vertices_;
+	};
+
+	/*
+	* GL side of DebugDraw: one streaming vertex buffer, orphaned and refilled
+	* every frame. Render thread only.
+	*/
+	class DebugRenderer {
+	public:
+		DebugRenderer() {}
+		~DebugRenderer();
+
+		DebugRenderer(const DebugRenderer&) = delete;
+
+	public:
+		void flush(const DebugDraw& draw, const ShaderProgram& sp, const glm::mat4& view_projection);
+
+	private:
+		GLuint vao_ = 0, vbo_ = 0;
+	};
+}
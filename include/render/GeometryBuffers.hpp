@@ -0,0 +1,100 @@
+#pragma once
+
+#include <span>
+
+#include <glad/glad.h>
+
+#include "Types.hpp"
+#include "render/VertexLayout.hpp"
+
+namespace dlb {
+
+	/*
+	* One VAO with a vertex and an index buffer holding every mesh of a
+	* model, meshes are ranges drawn with glDrawElementsBaseVertex.
+	* Render thread only.
+	*/
+	class GeometryBuffers {
+	public:
+		GeometryBuffers() {}
+		~GeometryBuffers();
+
+		GeometryBuffers(const GeometryBuffers&) = delete;
+		GeometryBuffers(GeometryBuffers&& x) noexcept;
+		GeometryBuffers& operator=(GeometryBuffers&& x) noexcept;
+
+	public:
+		/*
+		* Uploads both blobs in one call each, the attributes come from `V`.
+		*/
+		template<VertexType V>
+		void upload(std::span<const V> vertices, std::span<const uint> indices) {
+			create();
+
+			glBindVertexArray(vao_);
+
+			glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size_bytes(), vertices.data(), GL_STATIC_DRAW);
+
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size_bytes(), indices.data(), GL_STATIC_DRAW);
+
+			setupVertexAttributes<V>();
+
+			glBindVertexArray(0);
+		}
+
+		/*
+		* Creates the storage (and the attributes of `V`) without data, filled
+		*	afterwards in slices with uploadVertices/uploadIndices.
+		*/
+		template<VertexType V>
+		void allocate(size_t vertex_bytes, size_t index_bytes) {
+			create();
+
+			glBindVertexArray(vao_);
+
+			glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+			glBufferData(GL_ARRAY_BUFFER, vertex_bytes, nullptr, GL_STATIC_DRAW);
+
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes, nullptr, GL_STATIC_DRAW);
+
+			setupVertexAttributes<V>();
+
+			glBindVertexArray(0);
+		}
+
+		void uploadVertices(size_t offset, const void* data, size_t bytes) const {
+			glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+			glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+		}
+
+		void uploadIndices(size_t offset, const void* data, size_t bytes) const {
+			// the element binding is VAO state, ebo_ is already the one of vao_
+			glBindVertexArray(vao_);
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, bytes, data);
+			glBindVertexArray(0);
+		}
+
+		void bind() const {
+			glBindVertexArray(vao_);
+		}
+
+		/*
+		* `first_index` and `count` are in indices, the indices are relative to `base_vertex`.
+		*/
+		static void drawRange(uint first_index, uint count, uint base_vertex) {
+			glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, (const void*)(sizeof(uint) * (size_t)first_index), base_vertex);
+		}
+
+	private:
+		void create();
+		void destroy();
+
+	private:
+		GLuint vao_ = 0;
+		GLuint vbo_ = 0;
+		GLuint ebo_ = 0;
+	};
+}
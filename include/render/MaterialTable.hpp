@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Types.hpp"
+#include "ShaderProgram.hpp"
+
+namespace dlb {
+
+	/*
+	* std140 layout of the MaterialBlock uniform block of Model.frag.
+	*/
+	struct MaterialConstants {
+		glm::vec4 ambient{ 0.0f };
+		glm::vec4 diffuse{ 0.0f };
+		glm::vec4 specular{ 0.0f };
+		// atlas rectangles of the packed textures (PACK_TEXTURES)
+		glm::vec4 diffuse_rect{ 0.0f, 0.0f, 1.0f, 1.0f };
+		glm::vec4 specular_rect{ 0.0f, 0.0f, 1.0f, 1.0f };
+		// diffuse array, diffuse layer, specular array, specular layer
+		glm::ivec4 layers{ -1, 0, -1, 0 };
+		float shininess = 64.0f;
+		float padding[3]{};
+	};
+
+	static_assert(sizeof(MaterialConstants) == 112, "MaterialConstants must match the std140 MaterialBlock.");
+
+	struct MaterialTexture {
+		uint unit;
+		GLuint id;
+	};
+
+	/*
+	* Materials of a model compiled at load time. The constants of every
+	* material live in one uniform buffer and the texture units are fixed,
+	* so the samplers and the block binding of a program are set once
+	* (bindProgram) and switching material is a buffer range bind plus one
+	* texture bind per texture. Render thread only.
+	*/
+	class MaterialTable {
+	public:
+		static constexpr uint BLOCK_BINDING = 0;
+		static constexpr uint MAX_TEXTURES = 4;
+
+		// units 8..10 belong to ClusteredLighting
+		static constexpr uint DIFFUSE_UNIT = 0;
+		static constexpr uint SPECULAR_UNIT = 4;
+		static constexpr uint ARRAY_UNIT = 11;
+
+		MaterialTable() {}
+		~MaterialTable();
+
+		MaterialTable(const MaterialTable&) = delete;
+		MaterialTable(MaterialTable&& x) noexcept;
+		MaterialTable& operator=(MaterialTable&& x) noexcept;
+
+	public:
+		/*
+		* Returns the index of the material, identical materials share an index.
+		*/
+		uint add(const MaterialConstants& constants, std::span<const MaterialTexture> textures = {});
+
+		/*
+		* Creates the uniform buffer, no material can be added afterwards.
+		*/
+		void upload();
+
+		void bind(uint material) const;
+
+		uint size() const {
+			return materials_.size();
+		}
+
+		/*
+		* Size of the uniform buffer, 0 before upload().
+		*/
+		size_t getBufferBytes() const {
+			return (size_t)stride_ * materials_.size();
+		}
+
+		/*
+		* Points the material samplers of `sp` to the fixed units and its
+		* MaterialBlock to BLOCK_BINDING, once when the program is linked.
+		*/
+		static void bindProgram(const ShaderProgram& sp);
+
+	private:
+		struct Entry {
+			uint first_texture;
+			uint texture_count;
+		};
+
+		std::vector<MaterialConstants> constants_;
+		std::vector<Entry> materials_;
+		std::vector<MaterialTexture> textures_;
+
+		GLuint ubo_ = 0;
+		uint stride_ = 0;
+	};
+}
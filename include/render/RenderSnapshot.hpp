@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+#include <imgui.h>
+
+#include "Types.hpp"
+#include "Light.hpp"
+#include "render/CommandList.hpp"
+#include "render/DebugDraw.hpp"
+
+namespace dlb {
+
+	/*
+	* Copy of the ImGui draw lists of a frame. ImGui rewrites its own lists on
+	* the next NewFrame while the render thread may still be drawing them.
+	* The copies keep their capacity so steady frames do not allocate.
+	*/
+	class UiDrawData {
+	public:
+		void capture(const ImDrawData* src);
+
+		/*
+		* Null when nothing was captured this frame (headless).
+		*/
+		ImDrawData* get() {
+			return data_.Valid ? &data_ : nullptr;
+		}
+
+		void clear() {
+			data_.Valid = false;
+		}
+
+	private:
+		ImDrawData data_{};
+		std::vector<std::unique_ptr<ImDrawList>> lists_;
+		std::vector<ImDrawList*> list_ptrs_;
+	};
+
+	/*
+	* Everything the render thread needs to draw a frame. Written by the
+	* simulation thread, then read only by the render thread.
+	*/
+	struct RenderSnapshot {
+		u64 frame = 0;
+
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec3 eye_position;
+		float fov, aspect, z_near, z_far;
+		glm::vec2 viewport;
+
+		glm::vec3 bg_color;
+		bool wireframe = false;
+
+		GlobalLight global_light;
+		std::vector<LocalLight> lights;
+
+		// visible draws, sorted
+		CommandBuffer commands;
+
+		// lines, boxes, spheres and frustums, drawn in one call
+		DebugDraw debug;
+
+		UiDrawData ui;
+	};
+}
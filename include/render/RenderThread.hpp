@@ -0,0 +1,75 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "render/RenderSnapshot.hpp"
+
+namespace dlb {
+
+	/*
+	* Pipelines simulation and GL submission. The simulation thread fills a
+	* snapshot and publishes it, the render thread (which owns the GL context)
+	* draws it while the next one is being filled. With SLOTS snapshots the
+	* simulation is at most one frame ahead, so a frame costs
+	* max(simulation, render) instead of their sum.
+	*
+	* Without a thread, publish() renders inline.
+	*/
+	class RenderThread {
+	public:
+		static constexpr uint SLOTS = 2;
+
+		using RenderFn = std::function<void(RenderSnapshot&)>;
+		using ContextFn = std::function<void(bool current)>;
+
+		RenderThread() {}
+		~RenderThread();
+
+		RenderThread(const RenderThread&) = delete;
+
+	public:
+		/*
+		* `make_current` moves the GL context: it is called with false on the
+		* caller before the thread starts and with true on the render thread.
+		* stop() hands the context back the same way.
+		*/
+		void start(RenderFn render, ContextFn make_current, bool threaded = true);
+
+		/*
+		* Next snapshot to fill, waits while the render thread still reads it.
+		*/
+		RenderSnapshot& acquire();
+
+		void publish();
+
+		/*
+		* Renders the published snapshots, joins the thread and makes the GL
+		* context current on the caller again.
+		*/
+		void stop();
+
+		bool isThreaded() const {
+			return thread_.joinable();
+		}
+
+	private:
+		void loop();
+
+	private:
+		RenderSnapshot slots_[SLOTS];
+
+		u64 published_ = 0;
+		u64 rendered_ = 0;
+		bool stopping_ = false;
+
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::thread thread_;
+
+		RenderFn render_;
+		ContextFn make_current_;
+	};
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace dlb {
+
+	/*
+	* Pixel unpack buffer for texture uploads. stage() copies the pixels into
+	* freshly orphaned storage, so it never waits for the previous transfer,
+	* and the following glTexImage/glTexSubImage call reads them from the
+	* buffer without stalling the CPU. Render thread only.
+	*/
+	class StagingBuffer {
+	public:
+		StagingBuffer() {}
+		~StagingBuffer();
+
+		StagingBuffer(const StagingBuffer&) = delete;
+
+	public:
+		/*
+		* Leaves the buffer bound to GL_PIXEL_UNPACK_BUFFER and returns the
+		* pixels argument for glTex(Sub)Image, `data` itself when it could not
+		* be staged. Call unbind() after the texture calls.
+		*/
+		const void* stage(const void* data, size_t bytes);
+
+		void unbind() const {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+	private:
+		GLuint pbo_ = 0;
+	};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+
+#include "Types.hpp"
+#include "render/BlockCompression.hpp"
+#include "io/FileReader.hpp"
+
+namespace dlb {
+
+	/*
+	* Block compressed textures are cached as KTX2 files next to their
+	* source (`wood.jpg` -> `wood.jpg.ktx2`), a single 2D image with the full
+	* mip chain, no supercompression.
+	*/
+	constexpr const char* TEXTURE_CACHE_EXTENSION = ".ktx2";
+
+	constexpr unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct Ktx2Header {
+		unsigned char identifier[12];
+		uint vk_format;
+		uint type_size;
+		uint pixel_width;
+		uint pixel_height;
+		uint pixel_depth;
+		uint layer_count;
+		uint face_count;
+		uint level_count;
+		uint supercompression_scheme;
+		uint dfd_byte_offset;
+		uint dfd_byte_length;
+		uint kvd_byte_offset;
+		uint kvd_byte_length;
+		u64 sgd_byte_offset;
+		u64 sgd_byte_length;
+	};
+
+	static_assert(sizeof(Ktx2Header) == 80, "KTX2 header layout");
+
+	struct Ktx2Level {
+		u64 byte_offset;
+		u64 byte_length;
+		u64 uncompressed_byte_length;
+	};
+
+	std::string cookedTexturePath(const std::string& path);
+
+	bool writeKtx2File(const std::string& path, const CompressedImage& image);
+
+	/*
+	* Takes the mapping, `image.levels` point into it. Files written by other
+	* tools are accepted as long as they hold one of the BlockFormats.
+	*/
+	bool readKtx2File(FileView&& file, CompressedImage& image);
+
+	/*
+	* Maps the cached KTX2 of `path` when it is up to date, otherwise decodes
+	* the source, compresses it (BC5 for normal maps, BC1 or BC3 depending
+	* on the alpha otherwise) and writes the cache. Any thread.
+	*/
+	bool loadCompressedTexture(const std::string& path, bool normal_map, CompressedImage& image);
+}
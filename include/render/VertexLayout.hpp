@@ -0,0 +1,143 @@
+#pragma once
+
+#include <string>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "Types.hpp"
+
+namespace dlb {
+
+	enum class VertexFormat {
+		Float,
+		Float2,
+		Float3,
+		Float4,
+		// 4 bytes read as a 0..1 vec4 (colours)
+		UByte4Norm,
+		// 2 shorts read as a -1..1 vec2 (compact normals, uvs)
+		Short2Norm,
+		// 4 bytes read as a uvec4 (bone indices)
+		UByte4,
+		UInt,
+	};
+
+	struct VertexFormatInfo {
+		int components;
+		GLenum type;
+		uint bytes;
+		bool normalized;
+		// read with glVertexAttribIPointer
+		bool integer;
+		const char* glsl_type;
+	};
+
+	constexpr VertexFormatInfo vertexFormatInfo(VertexFormat format) {
+		switch (format) {
+		case VertexFormat::Float: return { 1, GL_FLOAT, 4, false, false, "float" };
+		case VertexFormat::Float2: return { 2, GL_FLOAT, 8, false, false, "vec2" };
+		case VertexFormat::Float3: return { 3, GL_FLOAT, 12, false, false, "vec3" };
+		case VertexFormat::Float4: return { 4, GL_FLOAT, 16, false, false, "vec4" };
+		case VertexFormat::UByte4Norm: return { 4, GL_UNSIGNED_BYTE, 4, true, false, "vec4" };
+		case VertexFormat::Short2Norm: return { 2, GL_SHORT, 4, true, false, "vec2" };
+		case VertexFormat::UByte4: return { 4, GL_UNSIGNED_BYTE, 4, false, true, "uvec4" };
+		case VertexFormat::UInt: return { 1, GL_UNSIGNED_INT, 4, false, true, "uint" };
+		}
+
+		return { 0, GL_NONE, 0, false, false, "" };
+	}
+
+	struct VertexAttribute {
+		uint location;
+		VertexFormat format;
+		size_t offset;
+		// shader input name
+		const char* name;
+	};
+
+	/*
+	* A vertex type declares its attributes once, as a constexpr static
+	* member function defined right after the struct (offsetof needs the
+	* complete type):
+	*
+	*	struct MyVertex {
+	*		glm::vec3 position;
+	*		static constexpr auto attributes();
+	*	};
+	*
+	*	constexpr auto MyVertex::attributes() {
+	*		return std::array{
+	*			dlb::VertexAttribute{ 0, dlb::VertexFormat::Float3, offsetof(MyVertex, position), "a_position" },
+	*		};
+	*	}
+	*/
+	template<typename V>
+	concept VertexType = requires {
+		{ V::attributes() };
+	};
+
+	/*
+	* Every attribute fits in the vertex and every location is used once.
+	*/
+	template<VertexType V>
+	constexpr bool isValidLayout() {
+		constexpr auto attributes = V::attributes();
+
+		for (size_t i = 0; i < attributes.size(); i++) {
+			if (attributes[i].offset + vertexFormatInfo(attributes[i].format).bytes > sizeof(V))
+				return false;
+
+			for (size_t j = i + 1; j < attributes.size(); j++)
+				if (attributes[i].location == attributes[j].location)
+					return false;
+		}
+
+		return true;
+	}
+
+	/*
+	* Attribute pointers of `V` for the bound VAO and GL_ARRAY_BUFFER.
+	*/
+	template<VertexType V>
+	void setupVertexAttributes() {
+		static_assert(isValidLayout<V>(), "Vertex layout has overlapping locations or attributes outside the vertex.");
+
+		constexpr auto attributes = V::attributes();
+
+		for (const auto& attribute : attributes) {
+			const auto info = vertexFormatInfo(attribute.format);
+			const void* offset = (const void*)(uintptr_t)attribute.offset;
+
+			glEnableVertexAttribArray(attribute.location);
+
+			if (info.integer)
+				glVertexAttribIPointer(attribute.location, info.components, info.type, sizeof(V), offset);
+			else
+				glVertexAttribPointer(attribute.location, info.components, info.type, info.normalized, sizeof(V), offset);
+		}
+	}
+
+	/*
+	* `layout (location = N) in <type> <name>;` lines of `V`, injected into
+	* the vertex stage by ShaderProgramBuilder::vertexInputs.
+	*/
+	template<VertexType V>
+	std::string vertexShaderInputs() {
+		std::string inputs;
+
+		for (const auto& attribute : V::attributes()) {
+			inputs += "layout (location = ";
+			inputs += std::to_string(attribute.location);
+			inputs += ") in ";
+			inputs += vertexFormatInfo(attribute.format).glsl_type;
+			inputs += " ";
+			inputs += attribute.name;
+			inputs += ";\n";
+		}
+
+		return inputs;
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Types.hpp"
+#include "Light.hpp"
+#include "ShaderProgram.hpp"
+
+namespace scene {
+
+	/*
+	* Clustered forward lighting.
+	* The view frustum is split in a CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z grid
+	*	(exponential depth slices), every frame the local lights are assigned to
+	*	the clusters they touch and the result is uploaded to three buffer
+	*	textures:
+	*	- lights: 4 RGBA32F texels per dlb::LocalLight
+	*	- grid: RG32UI (offset, count) per cluster
+	*	- indices: R32UI light indices, referenced by the grid
+	* Fragment shaders only loop over the lights of their own cluster.
+	*/
+	class ClusteredLighting {
+	public:
+		static constexpr uint CLUSTERS_X = 16;
+		static constexpr uint CLUSTERS_Y = 9;
+		static constexpr uint CLUSTERS_Z = 24;
+		static constexpr uint CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+		static constexpr uint MAX_LIGHTS_PER_CLUSTER = 256;
+
+		// texture units used by the buffer textures, above the material units
+		static constexpr int LIGHTS_UNIT = 8;
+		static constexpr int GRID_UNIT = 9;
+		static constexpr int INDICES_UNIT = 10;
+
+		ClusteredLighting() {}
+		~ClusteredLighting();
+
+		ClusteredLighting(const ClusteredLighting&) = delete;
+
+	public:
+		/*
+		* Assigns `lights` to the clusters of the frustum described by `view`
+		* and the perspective parameters (fov in degrees), then uploads the result.
+		*/
+		void update(const std::vector<dlb::LocalLight>& lights, const glm::mat4& view,
+			float fov, float aspect, float z_near, float z_far);
+
+		/*
+		* Binds the buffer textures and sets the cluster uniforms of `sp`.
+		*/
+		void bind(const dlb::ShaderProgram& sp, const glm::vec2& viewport) const;
+
+		uint getLightCount() const {
+			return light_count_;
+		}
+
+		uint getMaxClusterLights() const {
+			return max_cluster_lights_;
+		}
+
+	private:
+		void createBuffers();
+		void buildClusterBounds(float fov, float aspect, float z_near, float z_far);
+		void cullRange(uint begin, uint end);
+
+	private:
+		struct ClusterBounds {
+			glm::vec3 min;
+			glm::vec3 max;
+		};
+
+		std::vector<ClusterBounds> bounds_;
+
+		// view-space light spheres in SoA layout, padded to a multiple of 4
+		std::vector<float> xs_, ys_, zs_, radii_;
+
+		// MAX_LIGHTS_PER_CLUSTER entries per cluster, filled by the culling jobs
+		std::vector<uint> scratch_;
+		std::vector<uint> scratch_counts_;
+
+		std::vector<uint> grid_;
+		std::vector<uint> indices_;
+
+		// parameters the cluster bounds were built with
+		glm::vec4 frustum_{ 0.0f };
+
+		// written by the render thread, read by the ImGui panel
+		std::atomic<uint> light_count_ = 0;
+		std::atomic<uint> max_cluster_lights_ = 0;
+
+		GLuint lights_buffer_ = 0, grid_buffer_ = 0, indices_buffer_ = 0;
+		GLuint lights_texture_ = 0, grid_texture_ = 0, indices_texture_ = 0;
+	};
+}
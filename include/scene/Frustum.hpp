@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace scene {
+
+	/*
+	* The six planes of a view-projection matrix (Gribb/Hartmann), normals
+	* point inside.
+	*/
+	struct Frustum {
+		glm::vec4 planes[6];
+
+		static Frustum fromMatrix(const glm::mat4& view_projection) {
+			Frustum f;
+			glm::mat4 m = glm::transpose(view_projection);
+
+			f.planes[0] = m[3] + m[0];
+			f.planes[1] = m[3] - m[0];
+			f.planes[2] = m[3] + m[1];
+			f.planes[3] = m[3] - m[1];
+			f.planes[4] = m[3] + m[2];
+			f.planes[5] = m[3] - m[2];
+
+			return f;
+		}
+
+		/*
+		* Conservative test of the box `min`-`max` transformed by `transform`.
+		*/
+		bool intersects(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform) const {
+			glm::vec3 center = glm::vec3(transform * glm::vec4((min + max) * 0.5f, 1.0f));
+			glm::vec3 local_extent = (max - min) * 0.5f;
+
+			// world extent of the transformed box (Arvo)
+			glm::mat3 abs_basis{ glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])) };
+			glm::vec3 extent = abs_basis * local_extent;
+
+			for (const auto& plane : planes) {
+				glm::vec3 n{ plane };
+				float distance = glm::dot(n, center) + plane.w;
+				float radius = glm::dot(glm::abs(n), extent);
+
+				if (distance + radius < 0.0f)
+					return false;
+			}
+
+			return true;
+		}
+	};
+}
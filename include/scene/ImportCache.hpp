@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <mutex>
+
+#include "Types.hpp"
+#include "scene/ModelFile.hpp"
+#include "io/FileReader.hpp"
+
+namespace scene {
+
+	/*
+	* Persistent cache of imported models, content addressed: an entry is a
+	* .dlbm file named after the hash of the source bytes, of its
+	* dependencies (the material libraries of an OBJ) and of the importer
+	* signature, so a changed source simply misses. The hash is only
+	* computed when the size or modification time of one of those files
+	* changed since the last one (kept in a .stamp file per source path),
+	* otherwise the lookup reads no source at all. The least recently used
+	* entries are deleted once the directory outgrows its size limit.
+	*/
+	class ImportCache {
+	private:
+		ImportCache() {}
+
+	public:
+		static ImportCache& getInstance() {
+			static ImportCache cache{};
+			return cache;
+		}
+
+	public:
+		/*
+		* Before the first import, an empty directory disables the cache.
+		*/
+		void configure(const std::string& directory, u64 max_bytes);
+
+		bool isEnabled() const {
+			return !directory_.empty();
+		}
+
+		/*
+		* Empty when the source can not be read. Any thread.
+		*/
+		std::string key(const std::string& source) const;
+
+		static constexpr const char* STAMP_EXTENSION = ".stamp";
+
+		/*
+		* Maps the entry of `key`, `model` points into `file`. Any thread.
+		*/
+		bool load(const std::string& key, dlb::FileView& file, ModelView& model) const;
+
+		/*
+		* Writes the entry of `key` (atomically, concurrent stores of the same
+		* key are harmless) and trims the directory. Any thread.
+		*/
+		void store(const std::string& key, const ModelView& model);
+
+		/*
+		* Deletes the least recently used entries until the directory fits
+		* its size limit.
+		*/
+		void collectGarbage();
+
+	private:
+		std::string entryPath(const std::string& key) const;
+		std::string stampPath(const std::string& source) const;
+
+	private:
+		std::string directory_;
+		u64 max_bytes_ = 0;
+		std::mutex gc_mutex_;
+	};
+}
@@ -3,6 +3,7 @@
 #include <type_traits>
 #include <vector>
 #include <memory>
+#include <string>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -11,6 +12,11 @@
 #include "Types.hpp"
 #include "Texture.hpp"
 #include "ShaderProgram.hpp"
+#include "render/RenderSnapshot.hpp"
+#include "scene/Vertex.hpp"
+#include "scene/ModelFile.hpp"
+#include "render/GeometryBuffers.hpp"
+#include "render/MaterialTable.hpp"
 
 namespace scene {
 
@@ -18,25 +24,29 @@ namespace scene {
 		UseMaterials = 1 << 0,
 		UseTextures = 1 << 1,
 		DrawAABB = 1 << 2,
+		// pack the textures of the model into texture arrays, requires UseTextures
+		PackTextures = 1 << 3,
 	};
 
-	struct Material {
-		glm::vec3 ambient, diffuse, specular;
-		float shininess;
-	};
-
-	struct Vertex {
+	/*
+	* Defines of the Model.vert/Model.frag permutation matching `flags`,
+	* mirrors the branches taken by Mesh::draw.
+	*/
+	inline std::vector<std::string> modelFlagDefines(uint flags) {
+		std::vector<std::string> defines{};
 
-		static_assert(std::is_pod<glm::vec3>::value, "Vec3 type must be POD.");
+		if (flags & UseTextures) {
+			defines.push_back("USE_TEXTURES");
 
-		glm::vec3 position;
-		glm::vec3 normal;
-		glm::vec2 tex_coords;
-	};
+			if (flags & PackTextures)
+				defines.push_back("PACK_TEXTURES");
+		}
+		else if (flags & UseMaterials) {
+			defines.push_back("USE_MATERIALS");
+		}
 
-	struct BasicVertex {
-		glm::vec3 position;
-	};
+		return defines;
+	}
 
 	class BasicMesh {
 	public:
@@ -47,7 +57,7 @@ namespace scene {
 	public:
 		void feed(std::vector<BasicVertex>&& vertices, std::vector<uint> indices);
 
-		void draw(const dlb::ShaderProgram& sp, const glm::mat4& transformation, const glm::vec3& color);
+		void draw(const dlb::ShaderProgram& sp, const dlb::RenderSnapshot& frame, const glm::mat4& transformation, const glm::vec3& color);
 
 	private:
 		std::vector<BasicVertex> vertices_;
@@ -55,57 +65,46 @@ namespace scene {
 		uint VAO, VBO, EBO;
 	};
 
-	static_assert(std::is_pod<Vertex>::value, "Vertex type must be POD.");
-
+	/*
+	* Range of the GeometryBuffers of its model, drawn after the model bound
+	*	the buffers, the uniforms and the material (getMaterialIndex).
+	*/
 	class Mesh {
 	public:
-		Mesh(std::vector<Vertex>&& vertex, std::vector<uint>&& indices, dlb::Texture2DGroup&& texs, Material mat = {})
-			:vertices_(std::move(vertex)),
-			indices_(std::move(indices)),
-			textures_(std::move(texs)),
-			material_(mat)
-		{
-			VAO = 0;
-			VBO = 0;
-			EBO = 0;
-			defaultSetup();
+		Mesh(const MeshRecord& record, uint material_index)
+			:first_index_(record.first_index),
+			index_count_(record.index_count),
+			base_vertex_(record.first_vertex),
+			material_index_(material_index),
+			min_(record.min),
+			max_(record.max)
+		{}
+
+		void draw() const {
+			dlb::GeometryBuffers::drawRange(first_index_, index_count_, base_vertex_);
 		}
 
-		Mesh(Mesh&& x) noexcept
-			:vertices_(std::move(x.vertices_)),
-			indices_(std::move(x.indices_)),
-			textures_(std::move(x.textures_)) {
-
-			VAO = x.VAO;
-			VBO = x.VBO;
-			EBO = x.EBO;
-
-			material_ = x.material_;
-
-			x.VAO = 0;
-			x.VBO = 0;
-			x.EBO = 0;
+		/*
+		* Index of the material in the MaterialTable of the model.
+		*/
+		uint getMaterialIndex() const {
+			return material_index_;
 		}
 
-		~Mesh() {
-			glDeleteVertexArrays(1, &VAO);
-			glDeleteBuffers(1, &VBO);
-			glDeleteBuffers(1, &EBO);
+		const glm::vec3& getMinCoords() const {
+			return min_;
 		}
 
-		void defaultSetup();
-		
-		void draw(const dlb::ShaderProgram& sp, const glm::mat4& transformation, uint flags);
-
-		glm::vec3 getMinCoords();
-		glm::vec3 getMaxCoords();
+		const glm::vec3& getMaxCoords() const {
+			return max_;
+		}
 
 	private:
-		std::vector<Vertex> vertices_;
-		std::vector<uint> indices_;
-		dlb::Texture2DGroup textures_;
-		Material material_;
-
-		uint VAO, VBO, EBO;
+		uint first_index_;
+		uint index_count_;
+		uint base_vertex_;
+		uint material_index_;
+		glm::vec3 min_;
+		glm::vec3 max_;
 	};
 };
\ No newline at end of file
@@ -1,14 +1,14 @@
 #pragma once
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <vector>
+#include <atomic>
 
 #include "Mesh.hpp"
 #include "Texture.hpp"
+#include "scene/ModelFile.hpp"
+#include "render/StagingBuffer.hpp"
 
 namespace scene {
 
@@ -43,56 +43,171 @@ namespace scene {
 		}
 	};
 
+	/*
+	* Import runs on a pool thread, upload on the render thread in slices
+	* (see dlb::AssetStreamer). A model is drawn as a placeholder until it is
+	* Resident.
+	*/
+	enum class ModelState {
+		Queued,
+		Importing,
+		// CPU data ready, uploading
+		Imported,
+		Resident,
+		Failed,
+	};
+
+	/*
+	* Shared by every entity drawing it (see ApplicationSingleton::addModel),
+	* per-entity state such as the transform lives in the entity components.
+	*/
 	class Model {
 	public:
+		/*
+		* Nothing is loaded yet, see import() and uploadSlice().
+		*/
 		Model(const char* path, uint flags = ModelFlags::UseTextures)
-			:aabb_mesh_{} {
+			:path_(path) {
 			error = false;
-			model_ = glm::mat4(1.0f);
 			flags_ = flags;
-			load_model(path);
 		}
 
+		// import jobs and the streamer keep pointers to it
+		Model(const Model&) = delete;
+
 	public:
-		void draw(const dlb::ShaderProgram& sp, const glm::mat4& transformation, const glm::vec3& bb_color);
+		/*
+		* CPU stage, any thread: maps the cooked .dlbm next to the source when
+		*	it is up to date, else the scene::ImportCache entry of the source,
+		*	imports the source with assimp otherwise, and decodes the textures.
+		*/
+		void import();
+
+		/*
+		* GPU stage, GL thread: uploads the next slices (geometry chunks, one
+		*	texture at a time, the materials) until `deadline`
+		*	(FrameStats::nowNs clock) has passed. At least one slice is
+		*	uploaded per call, returns true once the model is Resident or failed.
+		*/
+		bool uploadSlice(dlb::StagingBuffer* staging, u64 deadline);
 
-		void translate(const glm::vec3& position) {
-			model_ = glm::translate(model_, position);
+		ModelState getState() const {
+			return state_.load(std::memory_order_acquire);
 		}
 
-		void scale(float x) {
-			model_ = glm::scale(model_, glm::vec3(x));
+		bool isResident() const {
+			return getState() == ModelState::Resident;
 		}
 
+		bool isImported() const {
+			auto state = getState();
+			return state == ModelState::Imported || state == ModelState::Resident;
+		}
+
+		/*
+		* Bounds of the imported data, only valid once isImported().
+		*	getAABB() is the copy owned by the simulation thread.
+		*/
+		const AABB& getImportedBounds() const {
+			return bounds_;
+		}
+
+		/*
+		* Simulation thread: copies the imported bounds to getAABB() once the
+		*	import finished, returns true when it did.
+		*/
+		bool syncBounds() {
+			if (bounds_synced_ || !isImported())
+				return false;
+
+			aabb_ = bounds_;
+			bounds_synced_ = true;
+			return true;
+		}
+
+		void draw(const dlb::ShaderProgram& sp, const dlb::RenderSnapshot& frame, const glm::mat4& transformation);
+
 		AABB& getAABB() {
 			return aabb_;
 		}
 
+		const AABB& getAABB() const {
+			return aabb_;
+		}
+
+		const std::string& getPath() const {
+			return path_;
+		}
+
+		uint getFlags() const {
+			return flags_;
+		}
+
 		/*
 		* Checks if two models are colliding
 		*/
 		bool AABBTest(Model& other, const glm::vec3& this_position, const glm::vec3& other_position);
 
 	private:
-		void load_model(const char* path);
-		void process_node(aiNode* node, const aiScene* scene);
-		Mesh process_mesh(aiMesh* mesh, const aiScene* scene);
-		Material process_material(aiMaterial* material, const aiScene* scene);
-		void load_material_textures(dlb::Texture2DGroupBuilder& builder, aiMaterial* mat, aiTextureType type);
-
-		void createAABB();
-		void createAABBMesh();
+		enum class UploadStep {
+			Geometry,
+			Textures,
+			Materials,
+		};
+
+		void prepareTextures();
+		void uploadGeometrySlice();
+		void uploadTextureSlice(dlb::StagingBuffer* staging);
+		void finishUpload();
+		void compileMaterials(std::vector<uint>& table_indices);
 
 	private:
+		std::string path_;
+		std::atomic<ModelState> state_{ ModelState::Queued };
+
+		/*
+		* Written by import(), read by the render thread while uploading.
+		*	`view_` points into `cooked_` (cooked file or cache entry) or `imported_`.
+		*/
+		dlb::FileView cooked_;
+		ModelData imported_;
+		ModelView view_;
+		AABB bounds_{ glm::vec3(0.0f), glm::vec3(0.0f) };
+
+		// decoded by import(), uploaded by uploadTextureSlice()
+		std::vector<dlb::Texture2DGroupBuilder> texture_builders_;
+		dlb::Texture2DArrayPacker texture_packer_;
+		std::vector<std::pair<int, int>> texture_slots_;
+
+		// upload progress, render thread only
+		UploadStep upload_step_ = UploadStep::Geometry;
+		size_t upload_offset_ = 0;
+		uint upload_material_ = 0;
+
+		dlb::GeometryBuffers geometry_;
 		std::vector<Mesh> meshes_;
-		BasicMesh aabb_mesh_;
+
+		// one group per material, only with ModelFlags::UseTextures
+		std::vector<dlb::Texture2DGroup> material_textures_;
+
+		/*
+		* Only used with ModelFlags::PackTextures, the (diffuse, specular)
+		* texture array layers of every material.
+		*/
+		std::vector<std::pair<dlb::Texture2DLayer, dlb::Texture2DLayer>> material_layers_;
+		dlb::Texture2DArraySet texture_arrays_;
+
+		// one entry per distinct material, compiled at load time
+		dlb::MaterialTable materials_;
+
 		std::string directory_;
-		glm::mat4 model_;
 
-		AABB aabb_;
+		// simulation thread copy of bounds_, the placeholder cube until the import finished
+		AABB aabb_{ glm::vec3(-0.5f), glm::vec3(0.5f) };
+		bool bounds_synced_ = false;
 
 		bool error;
 		// by default all models should use textures instead of materials.
 		uint flags_;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <glm/glm.hpp>
+
+#include "Types.hpp"
+#include "scene/Vertex.hpp"
+#include "io/FileReader.hpp"
+
+namespace scene {
+
+	/*
+	* A mesh is a range of the vertex and index blobs, its indices are
+	* relative to its first vertex. Meshes with identical payloads share
+	* their ranges.
+	*/
+	struct MeshRecord {
+		uint first_vertex;
+		uint vertex_count;
+		uint first_index;
+		uint index_count;
+		uint material;
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	struct MaterialRecord {
+		glm::vec3 ambient;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+		// 0 when the source does not define it
+		float shininess;
+		uint first_texture;
+		uint texture_count;
+	};
+
+	struct TextureRecord {
+		// path relative to the model directory, a range of the string blob
+		uint path_offset;
+		uint path_length;
+		// dlb::Texture2DType
+		uint type;
+	};
+
+	/*
+	* Everything a Model needs to create its GPU resources, either pointing
+	* into a mapped .dlbm file or into a ModelData.
+	*/
+	struct ModelView {
+		std::span<const Vertex> vertices;
+		std::span<const uint> indices;
+		std::span<const MeshRecord> meshes;
+		std::span<const MaterialRecord> materials;
+		std::span<const TextureRecord> textures;
+		std::string_view strings;
+		glm::vec3 min{ 0.0f };
+		glm::vec3 max{ 0.0f };
+
+		std::string_view texturePath(const TextureRecord& texture) const {
+			return strings.substr(texture.path_offset, texture.path_length);
+		}
+	};
+
+	/*
+	* Owning version of ModelView, filled by importModel.
+	*/
+	struct ModelData {
+		std::vector<Vertex> vertices;
+		std::vector<uint> indices;
+		std::vector<MeshRecord> meshes;
+		std::vector<MaterialRecord> materials;
+		std::vector<TextureRecord> textures;
+		std::string strings;
+		glm::vec3 min{ 0.0f };
+		glm::vec3 max{ 0.0f };
+
+		ModelView view() const {
+			return { vertices, indices, meshes, materials, textures, strings, min, max };
+		}
+	};
+
+	/*
+	* .dlbm layout (little endian): ModelFileHeader, then every section at a
+	* 16 byte aligned offset, in ModelFileSection order. Sections are the
+	* arrays of ModelView as they are in memory.
+	*/
+	constexpr char MODEL_FILE_MAGIC[4] = { 'D', 'L', 'B', 'M' };
+	// bump when a record or Vertex changes
+	constexpr uint MODEL_FILE_VERSION = 2;
+	constexpr const char* MODEL_FILE_EXTENSION = ".dlbm";
+
+	enum class ModelFileSection {
+		Vertices = 0,
+		Indices,
+		Meshes,
+		Materials,
+		Textures,
+		Strings,
+	};
+
+	constexpr int MODEL_FILE_SECTIONS = 6;
+
+	struct ModelFileHeader {
+		char magic[4];
+		uint version;
+		uint vertex_size;
+		uint reserved;
+		glm::vec3 min;
+		glm::vec3 max;
+		// importerSignature() of the importer that wrote it
+		u64 importer;
+		// (offset, element count) of every ModelFileSection
+		u64 sections[MODEL_FILE_SECTIONS][2];
+	};
+
+	/*
+	* `path` with its extension replaced by MODEL_FILE_EXTENSION.
+	*/
+	std::string cookedModelPath(const std::string& path);
+
+	bool writeModelFile(const std::string& path, const ModelView& model);
+
+	/*
+	* Validates the header and every range of `file`, `model` points into the mapping.
+	*/
+	bool readModelFile(const dlb::FileView& file, ModelView& model);
+
+	/*
+	* Imports `path` with assimp, used by the cooker and when no cooked file exists.
+	*/
+	bool importModel(const std::string& path, ModelData& model);
+
+	// bump when importModel converts differently
+	constexpr uint IMPORTER_VERSION = 3;
+
+	/*
+	* Changes whenever importModel may convert the same source differently:
+	*	the assimp version, its post-processing flags, IMPORTER_VERSION and
+	*	the file format.
+	*/
+	u64 importerSignature();
+}
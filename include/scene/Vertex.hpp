@@ -0,0 +1,46 @@
+#pragma once
+
+#include <type_traits>
+#include <array>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "render/VertexLayout.hpp"
+
+namespace scene {
+
+	struct Vertex {
+
+		static_assert(std::is_pod<glm::vec3>::value, "Vec3 type must be POD.");
+
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 tex_coords;
+
+		static constexpr auto attributes();
+	};
+
+	// matches the inputs of Model.vert
+	constexpr auto Vertex::attributes() {
+		return std::array{
+			dlb::VertexAttribute{ 0, dlb::VertexFormat::Float3, offsetof(Vertex, position), "a_position" },
+			dlb::VertexAttribute{ 1, dlb::VertexFormat::Float3, offsetof(Vertex, normal), "a_normal" },
+			dlb::VertexAttribute{ 2, dlb::VertexFormat::Float2, offsetof(Vertex, tex_coords), "a_tex_coord" },
+		};
+	}
+
+	static_assert(std::is_pod<Vertex>::value, "Vertex type must be POD.");
+
+	struct BasicVertex {
+		glm::vec3 position;
+
+		static constexpr auto attributes();
+	};
+
+	constexpr auto BasicVertex::attributes() {
+		return std::array{
+			dlb::VertexAttribute{ 0, dlb::VertexFormat::Float3, offsetof(BasicVertex, position), "a_position" },
+		};
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Types.hpp"
+
+namespace dlb {
+
+	/*
+	* On-disk cache of linked program binaries (glGetProgramBinary).
+	* Entries are keyed on the hash of every final stage source (defines
+	*	included) and of the driver string, a warm cache skips GLSL compilation
+	*	entirely. Any mismatch or rejected binary falls back to compiling.
+	*/
+	class ShaderCache {
+	private:
+		ShaderCache() {}
+
+	public:
+		static ShaderCache& getInstance() {
+			static ShaderCache cache{};
+			return cache;
+		}
+
+	public:
+		void setDirectory(const std::string& dir) {
+			directory_ = dir;
+		}
+
+		void setEnabled(bool value) {
+			enabled_ = value;
+		}
+
+		/*
+		* False when the context can not retrieve program binaries.
+		*/
+		bool available();
+
+		/*
+		* Cache key of a program made of `sources` (one per stage, in order).
+		*/
+		u64 key(const std::vector<std::string>& sources);
+
+		/*
+		* Creates `program` from the cached binary of `key`, returns false on a miss.
+		*/
+		bool load(u64 key, GLuint program);
+
+		/*
+		* Stores the binary of a linked `program` under `key`.
+		*/
+		void store(u64 key, GLuint program);
+
+	private:
+		std::string path(u64 key) const;
+
+	private:
+		std::string directory_ = "shader_cache";
+		std::string driver_;
+		bool enabled_ = true;
+		int available_ = -1;
+	};
+}
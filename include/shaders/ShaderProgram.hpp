@@ -3,11 +3,14 @@
 
 #include <string>
 #include <vector>
+#include <string_view>
 
 #include <gl/GL.h>
 
 #include <glm/glm.hpp>
 
+#include "Types.hpp"
+
 namespace dlb {
 
 	class ShaderProgram {
@@ -22,23 +25,38 @@ namespace dlb {
 			x.program_id = 0;
 		}
 
+		ShaderProgram& operator=(ShaderProgram&& x) noexcept {
+			std::swap(program_id, x.program_id);
+			return *this;
+		}
+
 		~ShaderProgram() {
 			glDeleteProgram(program_id);
 		}
 
-		int getProgramId() {
+		int getProgramId() const {
 			return program_id;
 		}
 
-		void setUniform(const std::string& name, bool value) const;
-		void setUniform(const std::string& name, int value) const;
-		void setUniform(const std::string& name, float value) const;
-		void setUniform(const std::string& name, const glm::vec2& value) const;
-		void setUniform(const std::string& name, const glm::vec3& value) const;
-		void setUniform(const std::string& name, const glm::vec4& value) const;
-		void setUniform(const std::string& name, const glm::mat2& value) const;
-		void setUniform(const std::string& name, const glm::mat3& value) const;
-		void setUniform(const std::string& name, const glm::mat4& value) const;
+		/*
+		* False for the empty slot of a program that is still compiling or
+		*	failed to link.
+		*/
+		bool isReady() const {
+			return program_id > 0;
+		}
+
+		// names are C strings so setting a uniform never allocates
+		void setUniform(const char* name, bool value) const;
+		void setUniform(const char* name, int value) const;
+		void setUniform(const char* name, float value) const;
+		void setUniform(const char* name, const glm::vec2& value) const;
+		void setUniform(const char* name, const glm::vec3& value) const;
+		void setUniform(const char* name, const glm::vec4& value) const;
+		void setUniform(const char* name, const glm::mat2& value) const;
+		void setUniform(const char* name, const glm::mat3& value) const;
+		void setUniform(const char* name, const glm::mat4& value) const;
+		void setUniform(const char* name, const int* values, int count) const;
 
 		void use() const;
 
@@ -57,6 +75,11 @@ namespace dlb {
 			std::string path;
 			GLenum type;
 			GLuint shaderId;
+
+			/*
+			* Final source, with the permutation defines injected
+			*/
+			std::string source;
 		};
 
 		ShaderProgramBuilder()
@@ -73,11 +96,116 @@ namespace dlb {
 			return *this;
 		}
 
+		/*
+		* Enables `#define name 1` in every stage of this permutation.
+		*/
+		ShaderProgramBuilder& define(const std::string& name) {
+			defines_.push_back(name);
+			return *this;
+		}
+
+		ShaderProgramBuilder& defines(const std::vector<std::string>& names) {
+			defines_.insert(defines_.end(), names.begin(), names.end());
+			return *this;
+		}
+
+		/*
+		* Vertex attribute declarations injected into the vertex stage,
+		*	usually dlb::vertexShaderInputs<V>() of the mesh vertex type.
+		*/
+		ShaderProgramBuilder& vertexInputs(const std::string& inputs) {
+			vertex_inputs_ = inputs;
+			return *this;
+		}
+
+		/*
+		* Programs are stored in and loaded from the ShaderCache by default.
+		*/
+		ShaderProgramBuilder& useCache(bool value) {
+			use_cache_ = value;
+			return *this;
+		}
+
 		ShaderProgram build();
 		void checkCompileErrors(int current_shader);
 
+	private:
+		std::string preprocess(std::string_view source, GLenum type) const;
+
+		friend class ShaderBatch;
+
 	private:
 		std::vector<Shader> shaders;
+		std::vector<std::string> defines_;
+		std::string vertex_inputs_;
+		bool use_cache_ = true;
 		int shader_program = -1;
 	};
+
+	/*
+	* Builds many programs at once.
+	* submit() first compiles every shader of every queued program and then
+	*	links every program without querying any status in between, so the
+	*	driver can overlap the work (in its own threads with
+	*	GL_KHR_parallel_shader_compile). isComplete() never blocks when the
+	*	extension is available, finish() checks the logs and returns the program.
+	*/
+	class ShaderBatch {
+	public:
+		ShaderBatch() {}
+
+		/*
+		* Queues a copy of `builder`, returns its index in the batch.
+		*/
+		uint add(const ShaderProgramBuilder& builder);
+
+		/*
+		* Starts compiling and linking every queued program.
+		*/
+		void submit();
+
+		bool isSubmitted(uint i) const {
+			return entries_[i].state != State::Queued;
+		}
+
+		bool isFinished(uint i) const {
+			return entries_[i].state == State::Finished;
+		}
+
+		bool isComplete(uint i) const;
+
+		/*
+		* Blocks until program i is linked and returns it, an empty program
+		*	if it failed to compile or link.
+		*/
+		ShaderProgram finish(uint i);
+
+		uint size() const {
+			return entries_.size();
+		}
+
+		/*
+		* Lets the driver use as many compiler threads as it wants.
+		*/
+		static void enableParallelCompile();
+
+	private:
+		enum class State {
+			Queued,
+			Compiling,
+			Finished,
+		};
+
+		struct Entry {
+			ShaderProgramBuilder builder;
+			// stage paths and defines, for the load report
+			std::string name;
+			GLuint program = 0;
+			u64 cache_key = 0;
+			bool from_cache = false;
+			State state = State::Queued;
+		};
+
+		std::vector<Entry> entries_;
+	};
 };
\ No newline at end of file
@@ -1,9 +1,9 @@
 #version 330 core
 
-out vec4 FragColor;
+in vec4 color;
 
-uniform vec3 u_color;
+out vec4 FragColor;
 
 void main() {
-	FragColor = vec4(u_color, .5f);
+	FragColor = color;
 }
@@ -0,0 +1,12 @@
+#version 330 core
+
+// vertex inputs are injected from the vertex layout (dlb::vertexShaderInputs)
+
+uniform mat4 u_view_projection;
+
+out vec4 color;
+
+void main() {
+	color = a_color;
+	gl_Position = u_view_projection * vec4(a_pos, 1.0f);
+}
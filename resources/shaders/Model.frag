@@ -0,0 +1,220 @@
+#version 330 core
+
+/*
+* Single source for every model program. ShaderProgramBuilder injects the
+* feature defines of the permutation right after #version
+* (see scene::modelFlagDefines):
+*	USE_TEXTURES	- diffuse and specular samplers
+*	PACK_TEXTURES	- with USE_TEXTURES, texture array layers (Texture2DArrayPacker)
+*	USE_MATERIALS	- material colors
+* Without any of them the normals are drawn.
+*/
+
+out vec4 FragColor;
+
+in vec3 normal;
+in vec3 frag_position;
+in vec2 tex_coord;
+in float view_depth;
+
+#if defined(USE_TEXTURES) || defined(USE_MATERIALS)
+#define LIT 1
+#endif
+
+#ifdef LIT
+
+/*
+* Constants of the current material (dlb::MaterialConstants), one range of
+* the model's MaterialTable buffer. Samplers use fixed texture units set
+* once per program by dlb::MaterialTable::bindProgram.
+*/
+layout (std140) uniform MaterialBlock {
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+	vec4 diffuse_rect;
+	vec4 specular_rect;
+	// diffuse array, diffuse layer, specular array, specular layer
+	ivec4 layers;
+	float shininess;
+} u_material;
+
+#endif
+
+#if defined(USE_TEXTURES) && defined(PACK_TEXTURES)
+
+/*
+* Textures are packed in texture arrays, a material selects the array, the
+* layer and the atlas rectangle of every texture.
+*/
+#define MAX_TEXTURE_ARRAYS 4
+
+uniform sampler2DArray u_texture_arrays[MAX_TEXTURE_ARRAYS];
+
+vec3 sampleLayer(int array, int layer, vec4 rect, vec3 fallback) {
+	// wrap inside the atlas rectangle, the gradients keep mip selection continuous across the seam
+	vec3 coord = vec3(fract(tex_coord) * rect.zw + rect.xy, float(layer));
+	vec2 dx = dFdx(tex_coord) * rect.zw;
+	vec2 dy = dFdy(tex_coord) * rect.zw;
+
+	// GLSL 330 only allows constant indices into sampler arrays
+	if (array == 0) return textureGrad(u_texture_arrays[0], coord, dx, dy).rgb;
+	if (array == 1) return textureGrad(u_texture_arrays[1], coord, dx, dy).rgb;
+	if (array == 2) return textureGrad(u_texture_arrays[2], coord, dx, dy).rgb;
+	if (array == 3) return textureGrad(u_texture_arrays[3], coord, dx, dy).rgb;
+
+	return fallback;
+}
+
+vec3 materialDiffuse() {
+	return sampleLayer(u_material.layers.x, u_material.layers.y, u_material.diffuse_rect, vec3(1.0f));
+}
+
+vec3 materialAmbient() {
+	return materialDiffuse();
+}
+
+vec3 materialSpecular() {
+	return sampleLayer(u_material.layers.z, u_material.layers.w, u_material.specular_rect, vec3(0.0f));
+}
+
+#elif defined(USE_TEXTURES)
+
+#define MAX_TEXTURES 4
+
+uniform sampler2D u_diffuse_textures[MAX_TEXTURES];
+uniform sampler2D u_specular_textures[MAX_TEXTURES];
+
+vec3 materialDiffuse() {
+	return texture(u_diffuse_textures[0], tex_coord).rgb;
+}
+
+vec3 materialAmbient() {
+	return materialDiffuse();
+}
+
+vec3 materialSpecular() {
+	return texture(u_specular_textures[0], tex_coord).rgb;
+}
+
+#elif defined(USE_MATERIALS)
+
+vec3 materialDiffuse() {
+	return u_material.diffuse.rgb;
+}
+
+vec3 materialAmbient() {
+	return u_material.ambient.rgb;
+}
+
+vec3 materialSpecular() {
+	return u_material.specular.rgb;
+}
+
+#endif
+
+#ifdef LIT
+
+struct DirectionalLight {
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+	vec3 direction;
+};
+
+uniform DirectionalLight u_light;
+uniform vec3 u_eye_position;
+
+/*
+* Clustered local lights (see scene::ClusteredLighting).
+* u_lights holds 4 texels per light: (position, radius), (diffuse, spot cutoff),
+* (specular, -), (direction, -). u_cluster_grid holds (offset, count) into
+* u_light_indices for every cluster.
+*/
+uniform samplerBuffer u_lights;
+uniform usamplerBuffer u_cluster_grid;
+uniform usamplerBuffer u_light_indices;
+uniform vec3 u_cluster_dims;
+uniform vec2 u_cluster_z;
+uniform vec2 u_viewport;
+
+vec3 calculateDirectionalLight(DirectionalLight l, vec3 norm, vec3 view_dir, vec3 diffuse_color, vec3 specular_color) {
+
+	vec3 light_direction = normalize(-l.direction);
+	float angle = max(dot(norm, light_direction), 0.0f);
+
+	vec3 reflect_direction = reflect(-light_direction, norm);
+
+	float spec = pow(max(dot(view_dir, reflect_direction), 0.0f), u_material.shininess);
+
+	vec3 ambient = l.ambient * materialAmbient();
+	vec3 diffuse = l.diffuse * (angle * diffuse_color);
+	vec3 specular = l.specular * (spec * specular_color);
+
+	vec3 result = ambient + diffuse + specular;
+	
+	return result;
+}
+
+uvec2 clusterLights() {
+	vec2 tile = floor(gl_FragCoord.xy / u_viewport * u_cluster_dims.xy);
+	float slice = floor(log(max(view_depth, 1e-4f)) * u_cluster_z.x - u_cluster_z.y);
+	vec3 cluster = clamp(vec3(tile, slice), vec3(0.0f), u_cluster_dims - 1.0f);
+
+	int index = int(cluster.x + u_cluster_dims.x * (cluster.y + u_cluster_dims.y * cluster.z));
+	return texelFetch(u_cluster_grid, index).xy;
+}
+
+vec3 calculateLocalLight(int light, vec3 norm, vec3 view_dir, vec3 diffuse_color, vec3 specular_color) {
+	vec4 position_radius = texelFetch(u_lights, light * 4 + 0);
+	vec4 diffuse_cutoff = texelFetch(u_lights, light * 4 + 1);
+	vec3 light_specular = texelFetch(u_lights, light * 4 + 2).rgb;
+
+	vec3 to_light = position_radius.xyz - frag_position;
+	float dist = length(to_light);
+	vec3 light_direction = to_light / max(dist, 1e-4f);
+
+	// smooth window so the light reaches exactly zero at its radius
+	float window = clamp(1.0f - pow(dist / position_radius.w, 4.0f), 0.0f, 1.0f);
+	float attenuation = window * window / (dist * dist + 1.0f);
+
+	if (diffuse_cutoff.w > -1.0f) {
+		vec3 spot_direction = texelFetch(u_lights, light * 4 + 3).xyz;
+		float cos_angle = dot(-light_direction, normalize(spot_direction));
+		attenuation *= smoothstep(diffuse_cutoff.w, mix(diffuse_cutoff.w, 1.0f, 0.1f), cos_angle);
+	}
+
+	float angle = max(dot(norm, light_direction), 0.0f);
+	vec3 reflect_direction = reflect(-light_direction, norm);
+	float spec = pow(max(dot(view_dir, reflect_direction), 0.0f), u_material.shininess);
+
+	vec3 diffuse = diffuse_cutoff.rgb * (angle * diffuse_color);
+	vec3 specular = light_specular * (spec * specular_color);
+
+	return (diffuse + specular) * attenuation;
+}
+
+void main() {
+    // properties
+    vec3 norm = normalize(normal);
+    vec3 view_dir = normalize(u_eye_position - frag_position);
+    vec3 diffuse_color = materialDiffuse();
+    vec3 specular_color = materialSpecular();
+
+    // phase 1: Directional lighting
+    vec3 result = calculateDirectionalLight(u_light, norm, view_dir, diffuse_color, specular_color);
+    // phase 2: Local lights of this cluster
+    uvec2 cluster = clusterLights();
+    for (uint i = 0u; i < cluster.y; i++)
+        result += calculateLocalLight(int(texelFetch(u_light_indices, int(cluster.x + i)).r), norm, view_dir, diffuse_color, specular_color);
+
+	FragColor = vec4(result, 1.0f);
+}
+
+#else
+
+void main() {
+	FragColor = vec4(normal, 1.0);
+}
+
+#endif
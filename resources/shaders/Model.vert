@@ -0,0 +1,26 @@
+#version 330 core
+
+// vertex inputs are injected from the vertex layout (dlb::vertexShaderInputs)
+
+out vec3 frag_position;
+out vec3 normal;
+out vec2 tex_coord;
+// positive distance to the camera, selects the light cluster depth slice
+out float view_depth;
+
+uniform mat4 u_model;
+uniform mat4 u_view;
+uniform mat4 u_projection;
+
+void main() {
+	//vec4 test = projection * view * model * vec4(1.0f
+	gl_Position = u_projection * u_view * u_model * vec4(a_position, 1.0f);
+
+	// the models are only translated and uniformly scaled so mat3(u_model) keeps normals correct
+	vec4 world_position = u_model * vec4(a_position, 1.0f);
+
+	normal = mat3(u_model) * a_normal;
+	tex_coord = a_tex_coord;
+	frag_position = world_position.xyz;
+	view_depth = -(u_view * world_position).z;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 330 core
+
+/*
+* Drawn while the real program of a mesh is still compiling, and on the
+* bounding box of models that are still streaming in.
+*/
+
+out vec4 FragColor;
+
+in vec3 normal;
+
+void main() {
+	float shade = 0.35f + 0.25f * abs(normalize(normal).y);
+	FragColor = vec4(vec3(shade), 1.0f);
+}
@@ -1,6 +1,12 @@
 #include <functional>
+#include <chrono>
 
 #include "Application.hpp"
+#include "profiling/FrameStats.hpp"
+#include "profiling/CpuProfiler.hpp"
+#include "profiling/GpuProfiler.hpp"
+#include "profiling/LoadStats.hpp"
+#include "jobs/ThreadPool.hpp"
 
 #include <GLFW/glfw3.h>
 
@@ -75,9 +81,9 @@ namespace dlb {
 		// height will be significantly larger than specified on retina displays.
 		auto& context = dlb::ApplicationSingleton::getInstance();
 
+		// the render thread sets the viewport from the snapshot
 		context.setWindowDimsH(height);
 		context.setWindowDimsW(width);
-		glViewport(0, 0, width, height);
 	}
 
 	void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
@@ -99,7 +105,33 @@ namespace dlb {
 		context.getCamera().updateDirection(glm::vec2(xoffset, yoffset));
 	}
 
+	void ApplicationSingleton::initHeadless() {
+		failOnCondition(!headless_.create(), [] {});
+
+		if (!gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			exit(-1);
+		}
+
+		headless_.createFramebuffer(window_dims.x, window_dims.y);
+
+		dlb::ShaderBatch::enableParallelCompile();
+
+		glViewport(0, 0, getWindowDims().x, getWindowDims().y);
+		glEnable(GL_DEPTH_TEST);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glEnable(GL_BLEND);
+
+		std::cout << "[HEADLESS] " << glGetString(GL_RENDERER) << " " << window_dims.x << "x" << window_dims.y << std::endl;
+	}
+
 	void ApplicationSingleton::init() {
+		ScopedLoadTimer timer{ LoadPhase::Context, launchOptions().headless ? "EGL context" : "GLFW window and context" };
+
+		if (launchOptions().headless) {
+			initHeadless();
+			return;
+		}
 
 		glfwInit();
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -117,6 +149,8 @@ namespace dlb {
 			exit(-1);
 		}
 
+		dlb::ShaderBatch::enableParallelCompile();
+
 		glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 		glViewport(0, 0, getWindowDims().x, getWindowDims().y);
 		glEnable(GL_DEPTH_TEST);
@@ -127,25 +161,241 @@ namespace dlb {
 		* Set the according viewport everytime the user resizes the window
 		*/
 		glfwSetFramebufferSizeCallback(window_, framebuffer_size_callback);
-		std::cout << "init1 done\n";
 
 		//glfwMaximizeWindow(window_);
-		std::cout << "init2 done\n";
 
 		glfwSetCursorPosCallback(window_, mouse_callback);
+	}
+	void ApplicationSingleton::submitShaders() {
+		shader_batch_.submit();
+	}
+
+	void ApplicationSingleton::pollShaders() {
+		submitShaders();
 
-		std::cout << "init3 done\n";
+		for (uint i = 0; i < shader_batch_.size(); i++) {
+			if (!shader_batch_.isFinished(i) && shader_batch_.isComplete(i)) {
+				shaders_[batch_shader_ids_[i]] = shader_batch_.finish(i);
+				MaterialTable::bindProgram(shaders_[batch_shader_ids_[i]]);
+			}
+		}
 	}
-	void ApplicationSingleton::updateTime() {
-		float current_time = glfwGetTime();
-		delta_time = current_time - last_frame;
-		last_frame = current_time;
 
-		frames++;
+	void ApplicationSingleton::finishShaders() {
+		submitShaders();
+
+		for (uint i = 0; i < shader_batch_.size(); i++) {
+			if (!shader_batch_.isFinished(i)) {
+				shaders_[batch_shader_ids_[i]] = shader_batch_.finish(i);
+				MaterialTable::bindProgram(shaders_[batch_shader_ids_[i]]);
+			}
+		}
+	}
+
+	bool ApplicationSingleton::isLoaded() const {
+		if (asset_streamer_.pendingCount() != 0)
+			return false;
+
+		for (uint i = 0; i < shader_batch_.size(); i++) {
+			if (!shader_batch_.isFinished(i))
+				return false;
+		}
+
+		return true;
+	}
+
+	void ApplicationSingleton::updateModels() {
+		for (auto& model : models_)
+			model->syncBounds();
+	}
+
+	void ApplicationSingleton::finishModels() {
+		asset_streamer_.finish();
+		updateModels();
+	}
+
+	/*
+	* Unit cube centered on the origin, one face per normal so the
+	* placeholder program shades it.
+	*/
+	void ApplicationSingleton::initPlaceholderBox() {
+		std::vector<scene::Vertex> vertices{};
+		std::vector<uint> indices{};
+
+		for (int axis = 0; axis < 3; axis++) {
+			for (float side : { -1.0f, 1.0f }) {
+				glm::vec3 normal(0.0f);
+				normal[axis] = side;
+
+				glm::vec3 u(0.0f), v(0.0f);
+				u[(axis + 1) % 3] = 1.0f;
+				v[(axis + 2) % 3] = 1.0f;
+
+				uint first = vertices.size();
+
+				for (glm::vec2 corner : { glm::vec2(-1, -1), glm::vec2(1, -1), glm::vec2(1, 1), glm::vec2(-1, 1) })
+					vertices.push_back({ 0.5f * (normal + corner.x * u + corner.y * v), normal, (corner + 1.0f) * 0.5f });
+
+				for (uint i : { 0, 1, 2, 2, 3, 0 })
+					indices.push_back(first + i);
+			}
+		}
+
+		ScopedLoadTimer timer{ LoadPhase::BufferUpload, "placeholder box" };
+		timer.addBytesUploaded(vertices.size() * sizeof(scene::Vertex) + indices.size() * sizeof(uint));
+
+		placeholder_box_.upload<scene::Vertex>(vertices, indices);
+	}
+
+	void ApplicationSingleton::drawPlaceholder(const scene::Model& model, const RenderSnapshot& frame, const glm::mat4& transform) {
+		static const uint box_indices = 36;
+
+		if (model.getState() == scene::ModelState::Failed)
+			return;
+
+		glm::mat4 bounds(1.0f);
 
-		if (current_time - last_time >= 1.0F) {
-			frames = 0;
-			last_time += 1.0f;
+		// the bounds are written by the import job before the state is
+		if (model.isImported()) {
+			const auto& aabb = model.getImportedBounds();
+			bounds = glm::translate(bounds, (aabb.min + aabb.max) * 0.5f);
+			bounds = glm::scale(bounds, glm::max(aabb.max - aabb.min, glm::vec3(1e-3f)));
 		}
+
+		const auto& sp = shaders_[placeholder_shader_];
+
+		sp.use();
+		sp.setUniform("u_model", transform * bounds);
+		sp.setUniform("u_view", frame.view);
+		sp.setUniform("u_projection", frame.projection);
+
+		placeholder_box_.bind();
+		dlb::GeometryBuffers::drawRange(0, box_indices, 0);
+		glBindVertexArray(0);
+	}
+
+	void ApplicationSingleton::updateLights(const RenderSnapshot& frame) {
+		clustered_lighting_.update(
+			frame.lights,
+			frame.view,
+			frame.fov,
+			frame.aspect,
+			frame.z_near,
+			frame.z_far);
+	}
+
+	void ApplicationSingleton::fillSnapshot(RenderSnapshot& frame) {
+		frame.aspect = window_dims.x / window_dims.y;
+		frame.view = camera.getView();
+		frame.projection = camera.getProjection(frame.aspect);
+		frame.eye_position = camera.getPosition();
+		frame.fov = camera.getFov();
+		frame.z_near = camera.getNear();
+		frame.z_far = camera.getFar();
+		frame.viewport = window_dims;
+
+		frame.bg_color = bg_color;
+		frame.wireframe = wireframe_mode;
+
+		frame.global_light = global_light;
+		// assign keeps the capacity of the slot
+		frame.lights.assign(lights_.begin(), lights_.end());
+	}
+
+	void ApplicationSingleton::replay(const RenderSnapshot& frame, std::span<const RenderCommandKey> commands) {
+		PROFILE_ZONE("ApplicationSingleton::replay");
+
+		for (const auto& key : commands) {
+			const auto& command = *key.command;
+
+			switch (command.type) {
+			case RenderCommandType::DrawModel: {
+				auto& model = getModel(command.model_id);
+
+				if (model.isResident())
+					model.draw(getShader(command.shader_id), frame, command.transform);
+				else
+					drawPlaceholder(model, frame, command.transform);
+
+				break;
+			}
+			}
+		}
+	}
+
+	void ApplicationSingleton::render(const RenderSnapshot& frame) {
+		PROFILE_ZONE("ApplicationSingleton::render");
+
+		pollShaders();
+
+		glViewport(0, 0, frame.viewport.x, frame.viewport.y);
+		glPolygonMode(GL_FRONT_AND_BACK, frame.wireframe ? GL_LINE : GL_FILL);
+		glClearColor(frame.bg_color.r, frame.bg_color.g, frame.bg_color.b, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		{
+			ScopedGpuPass pass{ "Streaming" };
+			asset_streamer_.update(launchOptions().upload_budget_ms);
+		}
+
+		if (LoadStats::getInstance().isRecording() && isLoaded())
+			LoadStats::getInstance().finishStartup(launchOptions().startup_report);
+
+		{
+			ScopedGpuPass pass{ "Lights" };
+			updateLights(frame);
+		}
+
+		{
+			ScopedGpuPass pass{ "Models" };
+			replay(frame, frame.commands.getPass(RenderPass::Opaque));
+		}
+
+		{
+			ScopedGpuPass pass{ "Debug" };
+			debug_renderer_.flush(frame.debug, getShader(debug_shader_), frame.projection * frame.view);
+		}
+	}
+
+	bool ApplicationSingleton::running() {
+		const int budget = launchOptions().frames;
+
+		if (budget > 0 && frame_count_ >= budget)
+			return false;
+
+		frame_count_++;
+
+		return isHeadless() || !glfwWindowShouldClose(window_);
+	}
+
+	void ApplicationSingleton::present() {
+		if (isHeadless())
+			return;
+
+		PROFILE_ZONE("SwapBuffers");
+
+		glfwSwapBuffers(window_);
+	}
+
+	void ApplicationSingleton::pollEvents() {
+		if (!isHeadless())
+			glfwPollEvents();
+	}
+
+	void ApplicationSingleton::makeContextCurrent(bool current) {
+		if (isHeadless())
+			headless_.makeCurrent(current);
+		else
+			glfwMakeContextCurrent(current ? window_ : nullptr);
+	}
+
+	void ApplicationSingleton::updateTime() {
+		// monotonic ns clock instead of glfwGetTime, GLFW is not initialized when headless
+		static const u64 start = FrameStats::nowNs();
+		double current_time = (FrameStats::nowNs() - start) / 1e9;
+
+		const double fixed = launchOptions().fixed_delta_time;
+		delta_time = fixed > 0.0 ? fixed : current_time - last_frame;
+		last_frame = current_time;
 	}
 }
\ No newline at end of file
@@ -33,6 +33,10 @@ namespace dlb {
 		return view;
 	}
 
+	glm::mat4 Camera::getProjection(float aspect) const {
+		return glm::perspective(glm::radians(fov), aspect, z_near, z_far);
+	}
+
 	void Camera::updateView() {
 		view = glm::lookAt(
 			position,
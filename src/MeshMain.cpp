@@ -16,6 +16,8 @@
 #include <functional>
 #include <format>
 #include <math.h>
+#include <cstdio>
+#include <cstdlib>
 
 #include "Camera.hpp"
 #include "ShaderProgram.hpp"
@@ -25,6 +27,12 @@
 #include "Types.hpp"
 #include "scene/Model.hpp"
 #include "ecs/ECS.hpp"
+#include "ecs/EntityInspector.hpp"
+#include "platform/Benchmark.hpp"
+#include "profiling/GpuProfiler.hpp"
+#include "profiling/CpuProfiler.hpp"
+#include "profiling/FrameStats.hpp"
+#include "render/RenderThread.hpp"
 
 
 void proccessInput() {
@@ -36,11 +44,7 @@ void proccessInput() {
 			glfwSetWindowShouldClose(window, true);
 		}
 		else if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) {
-
-			context.getWireframeMode() ?
-				glPolygonMode(GL_FRONT_AND_BACK, GL_POLYGON) :
-				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
+			// applied by the render thread
 			context.setWireframeMode(!context.getWireframeMode());
 		}
 		else if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
@@ -62,6 +66,30 @@ void proccessInput() {
 		//}
 }
 
+/*
+* Replaces the local lights with `count` lamps scattered on a grid around the
+* origin, useful to stress the light clusters.
+*/
+void scatterLamps(int count) {
+	auto& lights = dlb::ApplicationSingleton::getInstance().getLights();
+	lights.clear();
+
+	int side = (int)std::ceil(std::sqrt((float)count));
+
+	for (int i = 0; i < count; i++) {
+		float x = (i % side - side / 2) * 4.0f;
+		float z = (i / side - side / 2) * 4.0f;
+		float hue = (float)i / count;
+
+		lights.push_back({
+			.position = glm::vec3(x, 2.0f, z),
+			.radius = 6.0f,
+			.diffuse = glm::vec3(0.5f + 0.5f * sin(hue * 6.28f), 0.5f + 0.5f * sin(hue * 6.28f + 2.1f), 0.5f + 0.5f * sin(hue * 6.28f + 4.2f)) * 4.0f,
+			.specular = glm::vec3(1.0f),
+		});
+	}
+}
+
 void ImGuiPanelRendering(ecs::EntityPool& ep) {
 	auto& context = dlb::ApplicationSingleton::getInstance();
 
@@ -72,72 +100,186 @@ void ImGuiPanelRendering(ecs::EntityPool& ep) {
 	ImGui::SetNextWindowSize(ImVec2(300, 0));
 	ImGui::Begin("Scene Information");
 
-	ImGui::Text(std::format("FPS: {}/{}",
-		context.getFrames(), 1000.0f / (float)context.getFrames()).c_str());
+	dlb::FrameStats::getInstance().drawImGui();
 
 	ImGui::ColorEdit3("Bg Color", glm::value_ptr(context.getBgColor())); // Adjust light source color
 
-	ImGui::Text(std::format("X: {} Y: {} Z: {}",
-		context.getCamera().getPosition().x, context.getCamera().getPosition().y, context.getCamera().getPosition().z).c_str());
+	ImGui::Text("X: %.3f Y: %.3f Z: %.3f",
+		context.getCamera().getPosition().x, context.getCamera().getPosition().y, context.getCamera().getPosition().z);
 
-	ImGui::Text(std::format("Looking at X: {} Y: {} Z: {}",
-		context.getCamera().getDirection().x, context.getCamera().getDirection().y, context.getCamera().getDirection().z).c_str());
+	ImGui::Text("Looking at X: %.3f Y: %.3f Z: %.3f",
+		context.getCamera().getDirection().x, context.getCamera().getDirection().y, context.getCamera().getDirection().z);
 
 	ImGui::InputFloat("Camera Speed", &context.getCamera().getCameraSpeedRef());
 
 	ImGui::Checkbox("Pause ECS", &context.getPauseEcs());
 
+	// written by the render thread, only a rough reading
+	ImGui::Text("Textures: %.1f / %.0f MiB",
+		context.getTexture2DPool()->getResidentBytes() / 1048576.0, context.getTexture2DPool()->getBudget() / 1048576.0);
+
+	dlb::GpuProfiler::getInstance().drawImGui();
+	dlb::CpuProfiler::getInstance().drawImGui();
+
 	ImGui::Text("Global Light");
 	ImGui::InputFloat3("Light Direction", glm::value_ptr(context.getGlobalLight().direction), "%.2f");
 	ImGui::ColorEdit3("Ambient", glm::value_ptr(context.getGlobalLight().ambient));
 	ImGui::ColorEdit3("Diffuse", glm::value_ptr(context.getGlobalLight().diffuse));
 	ImGui::ColorEdit3("Specular", glm::value_ptr(context.getGlobalLight().specular));
 
-	for (const auto& entity : ep.getEntities()) {
-		auto& model = context.getModel(entity.model_id);
-		auto& aabb = model.getAABB();
-		ImGui::Text("Entity %d", entity.id);
-		ImGui::Text("MIN %.3f, %.3f %.3f", aabb.min.x, aabb.min.y, aabb.max.z);
-		ImGui::Text("MAX %.3f, %.3f %.3f", aabb.max.x, aabb.max.y, aabb.max.z);
-	}
+	static int lamp_count = 0;
+	ImGui::Text("Local Lights: %d (max %d per cluster)",
+		context.getClusteredLighting().getLightCount(), context.getClusteredLighting().getMaxClusterLights());
+	ImGui::InputInt("Lamps", &lamp_count, 50);
+	if (ImGui::Button("Scatter Lamps"))
+		scatterLamps(std::max(0, lamp_count));
+
+	static ecs::EntityInspector inspector{};
+	inspector.draw(ep);
 
 	ImGui::End();
 }
 
-int main() {
+/*
+* --headless				render offscreen (EGL surfaceless), no ImGui nor input
+* --frames N				stop after N frames
+* --bench-out file.csv		per-frame CPU/GPU timings
+* --screenshot file.ppm		last frame, headless only
+* --fixed-dt seconds		fixed simulation step (defaults to 1/60 when headless)
+* --size WxH				framebuffer size
+* --stats-out file.txt		session frame-time statistics
+* --trace file.json		Chrome trace of the CPU zones
+* --no-render-thread		submit GL on the main thread
+* --upload-budget ms		GL time per frame for streaming models in (default 2)
+* --no-texture-compression	upload the decoded sources instead of the BC/KTX2 cache
+* --texture-budget MB		estimated VRAM for textures before evicting (default 1024, 0 unlimited)
+* --import-cache dir		imported model cache (default .cache/import, "" disables)
+* --import-cache-size MB	size limit of the import cache (default 512)
+* --resources dir		loose directory of the res:// paths (default the source tree resources)
+* --pack file			.dlbp resource pack searched before the resources directory
+* --startup-report file.json	load phase breakdown of the startup (also printed)
+*/
+dlb::LaunchOptions parseLaunchOptions(int argc, char** argv) {
+	dlb::LaunchOptions options{};
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+
+		if (arg == "--headless")
+			options.headless = true;
+		else if (arg == "--frames" && has_value)
+			options.frames = std::atoi(argv[++i]);
+		else if (arg == "--bench-out" && has_value)
+			options.bench_output = argv[++i];
+		else if (arg == "--screenshot" && has_value)
+			options.screenshot = argv[++i];
+		else if (arg == "--stats-out" && has_value)
+			options.stats_output = argv[++i];
+		else if (arg == "--trace" && has_value)
+			options.trace_output = argv[++i];
+		else if (arg == "--no-render-thread")
+			options.render_thread = false;
+		else if (arg == "--fixed-dt" && has_value)
+			options.fixed_delta_time = std::atof(argv[++i]);
+		else if (arg == "--import-cache" && has_value)
+			options.import_cache = argv[++i];
+		else if (arg == "--import-cache-size" && has_value)
+			options.import_cache_mb = std::atoi(argv[++i]);
+		else if (arg == "--resources" && has_value)
+			options.resources = argv[++i];
+		else if (arg == "--pack" && has_value)
+			options.resource_pack = argv[++i];
+		else if (arg == "--startup-report" && has_value)
+			options.startup_report = argv[++i];
+		else if (arg == "--texture-budget" && has_value)
+			options.texture_budget_mb = std::atoi(argv[++i]);
+		else if (arg == "--no-texture-compression")
+			options.compress_textures = false;
+		else if (arg == "--upload-budget" && has_value)
+			options.upload_budget_ms = std::atof(argv[++i]);
+		else if (arg == "--size" && has_value)
+			std::sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+		else
+			std::cerr << "Unknown argument: " << arg << std::endl;
+	}
+
+	// reproducible runs
+	if (options.headless && options.fixed_delta_time <= 0.0)
+		options.fixed_delta_time = 1.0 / 60.0;
+
+	return options;
+}
+
+int main(int argc, char** argv) {
+	dlb::ApplicationSingleton::launchOptions() = parseLaunchOptions(argc, argv);
+
 	auto& context = dlb::ApplicationSingleton::getInstance();
 	auto window = context.getWindow();
+	const bool headless = context.isHeadless();
+
+	if (!context.launchOptions().trace_output.empty())
+		dlb::CpuProfiler::getInstance().setRecording(true);
 
 	stbi_set_flip_vertically_on_load(true);
 
 	// Initialize ImGui
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
-	auto& io = ImGui::GetIO();
-	io.Fonts->AddFontDefault();
-	ImGui_ImplGlfw_InitForOpenGL(window, true);
-	ImGui_ImplOpenGL3_Init("#version 330");
+	if (!headless) {
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		auto& io = ImGui::GetIO();
+		io.Fonts->AddFontDefault();
+		ImGui_ImplGlfw_InitForOpenGL(window, true);
+		ImGui_ImplOpenGL3_Init("#version 330");
+
+		// created now, NewFrame would otherwise create them on the simulation thread
+		ImGui_ImplOpenGL3_CreateDeviceObjects();
+	}
 
 #pragma region Shader programs
+	// every model program is a permutation of Model.vert/Model.frag
+	const std::string model_vert = "res://shaders/Model.vert";
+	const std::string model_frag = "res://shaders/Model.frag";
+	// generated from scene::Vertex::attributes()
+	const std::string model_inputs = dlb::vertexShaderInputs<scene::Vertex>();
+
 	auto textured_model_shader = context.addShader(
 		dlb::ShaderProgramBuilder{}
-		.vertexShader("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\shaders\\ModelWithTextures.vert")
-		.fragmentShader("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\shaders\\ModelWithTextures.frag"));
+		.vertexShader(model_vert)
+		.fragmentShader(model_frag)
+		.vertexInputs(model_inputs)
+		.defines(scene::modelFlagDefines(scene::ModelFlags::UseTextures)));
 
 	auto material_model_shader = context.addShader(
 		dlb::ShaderProgramBuilder{}
-		.vertexShader("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\shaders\\ModelWithMaterials.vert")
-		.fragmentShader("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\shaders\\ModelWithMaterials.frag"));
+		.vertexShader(model_vert)
+		.fragmentShader(model_frag)
+		.vertexInputs(model_inputs)
+		.defines(scene::modelFlagDefines(scene::ModelFlags::UseMaterials)));
 
 	auto notextures_model_shader = context.addShader(
 		dlb::ShaderProgramBuilder{}
-			.vertexShader("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\shaders\\ModelWithMaterials.vert")
-			.fragmentShader("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\shaders\\ModelWithout.frag"));
+			.vertexShader(model_vert)
+			.fragmentShader(model_frag)
+			.vertexInputs(model_inputs));
+
+	// models loaded with ModelFlags::PackTextures
+	auto packed_textures_model_shader = context.addShader(
+		dlb::ShaderProgramBuilder{}
+			.vertexShader(model_vert)
+			.fragmentShader(model_frag)
+			.vertexInputs(model_inputs)
+			.defines(scene::modelFlagDefines(scene::ModelFlags::UseTextures | scene::ModelFlags::PackTextures)));
+
+	// the programs compile while the models below are imported
+	context.submitShaders();
 #pragma endregion
 
 #pragma region Scene Configuration
-	auto tree_model = context.addModel("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\models\\low_poly_tree\\Lowpoly_tree_sample.obj", scene::ModelFlags::UseMaterials | scene::ModelFlags::DrawAABB);
-	auto wheel5 = context.addModel("C:\\Users\\Diego\\Documents\\Code\\LearnOpenGL\\resources\\models\\5wheel\\wheel5.obj", scene::ModelFlags::UseMaterials | scene::ModelFlags::DrawAABB);
+	auto tree_model = context.addModel("res://models/low_poly_tree/Lowpoly_tree_sample.obj", scene::ModelFlags::UseMaterials | scene::ModelFlags::DrawAABB);
+	auto wheel5 = context.addModel("res://models/5wheel/wheel5.obj", scene::ModelFlags::UseMaterials | scene::ModelFlags::DrawAABB);
+	// the same file again, its textures packed into arrays
+	auto wheel5_packed = context.addModel("res://models/5wheel/wheel5.obj", scene::ModelFlags::UseTextures | scene::ModelFlags::PackTextures | scene::ModelFlags::DrawAABB);
 
 	ecs::EntityPool entity_pool{};
 
@@ -156,33 +298,131 @@ int main() {
 		notextures_model_shader,
 		wheel5
 	);
+
+	entity_pool.newEntity(
+		glm::vec3(10.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f),
+		glm::vec3(0),
+		packed_textures_model_shader,
+		wheel5_packed
+	);
 #pragma endregion
 
-	while (!glfwWindowShouldClose(window)) {
-		proccessInput();
-		context.updateTime();
-		const auto& bg_color = context.getBgColor();
-		glClearColor(bg_color.r, bg_color.g, bg_color.b, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// benchmarks must not measure placeholder frames
+	if (headless) {
+		context.finishShaders();
+		context.finishModels();
+	}
+
+	dlb::BenchmarkRecorder benchmark{};
+
+	auto& gpu_profiler = dlb::GpuProfiler::getInstance();
+	auto& cpu_profiler = dlb::CpuProfiler::getInstance();
+	auto& frame_stats = dlb::FrameStats::getInstance();
+
+	/*
+	* Runs on the render thread, which owns the GL context from start() to stop().
+	*/
+	auto render_frame = [&](dlb::RenderSnapshot& frame) {
+		{
+			dlb::ScopedFramePhase phase{ dlb::FramePhase::RenderSubmit };
+
+			benchmark.beginFrame();
+			gpu_profiler.beginFrame();
+			gpu_profiler.beginPass("Frame");
+
+			context.render(frame);
+
+			if (auto* ui = frame.ui.get()) {
+				dlb::ScopedGpuPass pass{ "ImGui" };
+				ImGui_ImplOpenGL3_RenderDrawData(ui);
+			}
+
+			gpu_profiler.endPass();
+			gpu_profiler.endFrame();
+			benchmark.endFrame();
+		}
+
+		dlb::ScopedFramePhase phase{ dlb::FramePhase::Swap };
+		context.present();
+	};
+
+	dlb::RenderThread render_thread{};
+	render_thread.start(render_frame,
+		[&context](bool current) { context.makeContextCurrent(current); },
+		context.launchOptions().render_thread);
+
+	while (context.running()) {
+		frame_stats.beginFrame();
+		cpu_profiler.beginFrame();
+
+		{
+			dlb::ScopedFramePhase phase{ dlb::FramePhase::Simulation };
+
+			context.pollEvents();
+
+			if (!headless)
+				proccessInput();
+
+			context.updateTime();
+			context.updateModels();
+			entity_pool.iterate();
+		}
 
 #pragma region ImGui Rendering
-		ImGuiPanelRendering(entity_pool);
-		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		if (!headless) {
+			PROFILE_ZONE("ImGui");
+			ImGuiPanelRendering(entity_pool);
+			ImGui::Render();
+		}
 #pragma endregion
 
-		entity_pool.iterate();
+		{
+			// waits while the render thread still draws this slot
+			auto& frame = render_thread.acquire();
+
+			frame.ui.capture(headless ? nullptr : ImGui::GetDrawData());
+			context.fillSnapshot(frame);
+			entity_pool.buildCommands(frame);
+			entity_pool.drawDebug(frame.debug);
+
+			render_thread.publish();
+		}
+
+		cpu_profiler.endFrame();
+		frame_stats.endFrame();
+	}
+
+	// the context is current on this thread again
+	render_thread.stop();
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+	if (headless && !context.launchOptions().screenshot.empty())
+		context.getHeadlessContext().writePPM(context.launchOptions().screenshot);
+
+	if (!context.launchOptions().bench_output.empty())
+		benchmark.writeCSV(context.launchOptions().bench_output);
+
+	benchmark.printSummary();
+	frame_stats.printSummary();
+
+	if (!context.launchOptions().stats_output.empty())
+		frame_stats.writeSummary(context.launchOptions().stats_output);
+
+	if (!context.launchOptions().trace_output.empty()) {
+		dlb::CpuProfiler::getInstance().collect();
+		dlb::CpuProfiler::getInstance().writeChromeTrace(context.launchOptions().trace_output);
 	}
 
+	if (headless)
+		context.getHeadlessContext().destroyFramebuffer();
+
 	// Cleanup ImGui
-	ImGui_ImplOpenGL3_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
-	ImGui::DestroyContext();
+	if (!headless) {
+		ImGui_ImplOpenGL3_Shutdown();
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext();
+	}
 
 	glfwTerminate();
 	return 0;
 }
-
@@ -6,73 +6,702 @@
 
 #include <iostream>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <functional>
+
+#include "profiling/CpuProfiler.hpp"
+#include "profiling/FrameStats.hpp"
+#include "jobs/ThreadPool.hpp"
+#include "render/TextureCache.hpp"
+#include "io/FileReader.hpp"
+#include "profiling/LoadStats.hpp"
 
 
 namespace dlb {
-	Texture2DGroup Texture2DGroupBuilder::build() {
-		Texture2DGroup tex_group{};
+	DecodedImage::~DecodedImage() {
+		if (pixels)
+			stbi_image_free(pixels);
+	}
 
-		std::vector<Texture2D> texs( textures.size() );
+	DecodedImage::DecodedImage(DecodedImage&& x) noexcept {
+		*this = std::move(x);
+	}
 
-		assert(texs.size() == textures.size() && "This should not fail");
+	DecodedImage& DecodedImage::operator=(DecodedImage&& x) noexcept {
+		std::swap(width, x.width);
+		std::swap(height, x.height);
+		std::swap(channels, x.channels);
+		std::swap(pixels, x.pixels);
+		std::swap(compressed, x.compressed);
+		return *this;
+	}
 
-		//glGenTextures(texs.size()), (GLuint*)(texs.data()));
+	bool DecodedImage::load(const std::string& path, int desired_channels) {
+		int file_channels = 0;
+		ScopedLoadTimer timer{ LoadPhase::TextureDecode, path };
+		const FileView file = FileReader::open(path);
+		timer.addBytesRead(file.size());
 
-		auto& context = ApplicationSingleton::getInstance();
+		if (file)
+			pixels = stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &file_channels, desired_channels);
+
+		channels = desired_channels ? desired_channels : file_channels;
 
-		for (int i = 0; i < textures.size(); i++) {
+		if (!pixels)
+			std::cout << "Failed to load texture: " << path << std::endl;
 
-			std::cout << "Loading: " << textures[i].path;
+		return pixels != nullptr;
+	}
 
-			if (context.getTexture2DPool()->exists(textures[i].path)) {
-				
-				std::cout << "[REUSED]" << std::endl;
+	static int desiredChannels(const Texture2DConfiguration& texture) {
+		return texture.path.ends_with("png") ? STBI_rgb_alpha : 0;
+	}
 
-				texs.push_back(context.getTexture2DPool()->reuse(textures[i].path));
-				continue;
+	static GLenum glBlockFormat(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+		}
+
+		return GL_NONE;
+	}
+
+	/*
+	* Every level of the chain to the bound GL_TEXTURE_2D, no mipmap generation.
+	*/
+	static void uploadCompressed(const CompressedImage& image, StagingBuffer* staging) {
+		const GLenum format = glBlockFormat(image.format);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levels.size() - 1);
+
+		for (uint level = 0; level < image.levels.size(); level++) {
+			const auto& data = image.levels[level];
+			const void* pixels = staging ? staging->stage(data.data(), data.size()) : data.data();
+
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, format,
+				std::max(1, image.width >> level), std::max(1, image.height >> level), 0, data.size(), pixels);
+
+			if (staging)
+				staging->unbind();
+		}
+	}
+
+	Texture2DGroup& Texture2DGroup::operator=(Texture2DGroup&& rhs) noexcept {
+		release();
+		textures = std::move(rhs.textures);
+		rhs.textures.clear();
+		return *this;
+	}
+
+	Texture2DGroup::~Texture2DGroup() {
+		release();
+	}
+
+	void Texture2DGroup::release() {
+		for (const auto& texture : textures)
+			Texture2DPool::getInstance().release(texture.id);
+
+		textures.clear();
+	}
+
+	Texture2D Texture2DPool::reuse(const std::string& path) {
+		std::lock_guard lock{ mutex_ };
+
+		auto& entry = texture_pool_.at(path);
+
+		if (entry.refs++ == 0)
+			lru_.erase(entry.lru);
+
+		return entry.texture;
+	}
+
+	void Texture2DPool::insert(const std::string& path, const Texture2D& tex, size_t bytes, bool compressed) {
+		{
+			std::lock_guard lock{ mutex_ };
+
+			assert(texture_pool_.find(path) == texture_pool_.end());
+
+			Entry entry{};
+			entry.texture = tex;
+			entry.refs = 1;
+			entry.bytes = bytes;
+			entry.compressed = compressed;
+			texture_pool_.insert({ path, std::move(entry) });
+			paths_.insert({ tex.id, path });
+			decoding_.erase(path);
+
+			resident_bytes_ += bytes;
+		}
+
+		trim();
+	}
+
+	void Texture2DPool::release(GLuint id) {
+		{
+			std::lock_guard lock{ mutex_ };
+
+			auto it = paths_.find(id);
+
+			if (it == paths_.end())
+				return;
+
+			auto& entry = texture_pool_.at(it->second);
+			assert(entry.refs > 0);
+
+			if (--entry.refs == 0)
+				entry.lru = lru_.insert(lru_.end(), it->second);
+		}
+
+		trim();
+	}
+
+	void Texture2DPool::setBudget(size_t bytes) {
+		{
+			std::lock_guard lock{ mutex_ };
+			budget_ = bytes;
+		}
+
+		trim();
+	}
+
+	void Texture2DPool::evict(const std::string& path) {
+		auto it = texture_pool_.find(path);
+		auto& entry = it->second;
+
+		glDeleteTextures(1, &entry.texture.id);
+
+		resident_bytes_ -= entry.bytes;
+		lru_.erase(entry.lru);
+		paths_.erase(entry.texture.id);
+		texture_pool_.erase(it);
+	}
+
+	// a texture under pressure keeps at least this size
+	static constexpr int MIN_DROPPED_SIZE = 64;
+
+	void Texture2DPool::readDroppedMips(MipDrop&& drop) {
+		FileView file = FileReader::open(cookedTexturePath(drop.path));
+		const auto& image = drop.image;
+
+		drop.valid = file && readKtx2File(std::move(file), drop.image) &&
+			(size_t)drop.skip < image.levels.size() && std::max(image.width >> drop.skip, image.height >> drop.skip) >= MIN_DROPPED_SIZE;
+
+		std::lock_guard lock{ mutex_ };
+		drops_.push_back(std::move(drop));
+	}
+
+	void Texture2DPool::uploadDroppedMips(u64 deadline) {
+		PROFILE_ZONE("Texture2DPool::uploadDroppedMips");
+
+		bool dropped = false;
+
+		do {
+			MipDrop drop{};
+
+			{
+				std::lock_guard lock{ mutex_ };
+
+				if (drops_.empty())
+					break;
+
+				drop = std::move(drops_.front());
+				drops_.pop_front();
+
+				// evicted while the file was read, only this thread deletes textures
+				auto it = texture_pool_.find(drop.path);
+
+				if (it == texture_pool_.end() || it->second.texture.id != drop.id)
+					continue;
+
+				it->second.shrinking = false;
+
+				if (!drop.valid) {
+					it->second.shrinkable = false;
+					continue;
+				}
+			}
+
+			const auto& image = drop.image;
+			const int skip = drop.skip;
+			const GLenum format = glBlockFormat(image.format);
+			size_t bytes = 0;
+
+			glBindTexture(GL_TEXTURE_2D, drop.id);
+
+			// the same texture object so every handle stays valid, level 0 is the old level `skip`
+			for (size_t level = skip; level < image.levels.size(); level++) {
+				const auto& data = image.levels[level];
+				glCompressedTexImage2D(GL_TEXTURE_2D, level - skip, format,
+					std::max(1, image.width >> level), std::max(1, image.height >> level), 0, data.size(), data.data());
+				bytes += data.size();
+			}
+
+			// free the old smallest levels
+			for (size_t level = image.levels.size() - skip; level < image.levels.size(); level++)
+				glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levels.size() - skip - 1);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			std::lock_guard lock{ mutex_ };
+			auto& entry = texture_pool_.at(drop.path);
+
+			resident_bytes_ -= entry.bytes - bytes;
+			entry.bytes = bytes;
+			entry.dropped_levels = skip;
+			dropped = true;
+		} while (FrameStats::nowNs() < deadline);
+
+		// still over budget, the next level of the largest ones
+		if (dropped)
+			trim();
+	}
+
+	void Texture2DPool::trim() {
+		std::vector<MipDrop> requests{};
+
+		{
+			std::lock_guard lock{ mutex_ };
+
+			if (budget_ == 0)
+				return;
+
+			while (resident_bytes_ > budget_ && !lru_.empty())
+				evict(lru_.front());
+
+			if (resident_bytes_ <= budget_)
+				return;
+
+			// every remaining texture is in use, shrink the largest ones by a level
+			std::vector<std::pair<size_t, const std::string*>> sizes{};
+			// dropping the top level frees about three quarters of a texture
+			size_t saving = 0;
+
+			for (const auto& [path, entry] : texture_pool_) {
+				if (entry.shrinking)
+					saving += entry.bytes * 3 / 4;
+				else if (entry.compressed && entry.shrinkable)
+					sizes.push_back({ entry.bytes, &path });
 			}
 
-			glGenTextures(1, (GLuint*)&texs[i].id);
-			texs[i].type = textures[i].type;
+			std::sort(sizes.begin(), sizes.end(), [](const auto& a, const auto& b) {
+				return a.first > b.first;
+			});
+
+			const size_t excess = resident_bytes_ - budget_;
+
+			for (const auto& [bytes, path] : sizes) {
+				if (saving >= excess)
+					break;
+
+				auto& entry = texture_pool_.at(*path);
+				entry.shrinking = true;
+				saving += bytes * 3 / 4;
+
+				MipDrop drop{};
+				drop.path = *path;
+				drop.id = entry.texture.id;
+				drop.skip = entry.dropped_levels + 1;
+				requests.push_back(std::move(drop));
+			}
+		}
 
-			context.getTexture2DPool()->insert(textures[i].path, texs[i]);
+		// the KTX2 files are read on the pool, uploadDroppedMips() applies them within the streaming budget
+		for (auto& drop : requests) {
+			ThreadPool::getInstance().submit([this, drop = std::move(drop)]() mutable {
+				readDroppedMips(std::move(drop));
+			});
+		}
+	}
 
-			// all upcoming GL_TEXTURE_2D operations now have effect on this texture object
-			glBindTexture(GL_TEXTURE_2D, texs[i].id);
-			// set the texture wrapping parameters
-			// set texture wrapping to GL_REPEAT (default wrapping method)
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textures[i].wrap);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textures[i].wrap);
-			// set texture filtering parameters
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, textures[i].min_filtering);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, textures[i].mag_filtering);
+	std::shared_ptr<DecodedImage> Texture2DPool::decode(const Texture2DConfiguration& texture) {
+		const std::string& path = texture.path;
 
-			int width, height, nr_channels;
+		std::promise<std::shared_ptr<DecodedImage>> promise{};
+		std::shared_future<std::shared_ptr<DecodedImage>> future{};
 
-			bool is_png = textures[i].path.ends_with("png");
+		{
+			std::lock_guard lock{ mutex_ };
 
-			unsigned char* data = stbi_load(textures[i].path.c_str(), &width, &height, &nr_channels, is_png ? STBI_rgb_alpha : 0);
+			if (texture_pool_.find(path) != texture_pool_.end())
+				return nullptr;
 
-			GLenum format = GL_RED;
-			if (nr_channels == 1)
-				format = GL_RED;
-			else if (nr_channels == 3)
-				format = GL_RGB;
-			else if (nr_channels == 4)
-				format = GL_RGBA;
+			auto it = decoding_.find(path);
 
-			if (data) {
-				glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format , GL_UNSIGNED_BYTE, data);
-				glGenerateMipmap(GL_TEXTURE_2D);
+			// another thread decodes it, wait for the same image
+			if (it != decoding_.end()) {
+				future = it->second;
 			}
 			else {
-				std::cout << "Failed to load texture: " << textures[i].path << std::endl;
+				decoding_.insert({ path, promise.get_future().share() });
+				future = {};
 			}
-			stbi_image_free(data);
 		}
 
-		tex_group.setTextures(std::move(texs));
+		// the owner never waits on other jobs, blocking here can not deadlock
+		if (future.valid())
+			return future.get();
+
+		auto image = std::make_shared<DecodedImage>();
+
+		if (compress_)
+			loadCompressedTexture(path, texture.type == Texture2DType::Normal, image->compressed);
+		else
+			image->load(path, desiredChannels(texture));
+
+		promise.set_value(image);
+		return image;
+	}
+
+	void Texture2DGroupBuilder::decode() {
+		PROFILE_ZONE("Texture2DGroupBuilder::decode");
+
+		if (decoded_all_)
+			return;
+
+		decoded_.resize(textures.size());
+
+		auto& pool = Texture2DPool::getInstance();
+
+		// one texture per job, the slowest decode bounds the whole group
+		ThreadPool::getInstance().parallelFor(textures.size(), 1, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++)
+				decoded_[i] = pool.decode(textures[i]);
+		});
+
+		decoded_all_ = true;
+	}
+
+	bool Texture2DGroupBuilder::uploadNext(StagingBuffer* staging) {
+		if (next_ == 0) {
+			decode();
+			built_.resize(textures.size());
+		}
+
+		if (next_ >= textures.size())
+			return true;
+
+		const uint i = next_++;
+		auto& context = ApplicationSingleton::getInstance();
+
+		if (context.getTexture2DPool()->exists(textures[i].path)) {
+			built_[i] = { context.getTexture2DPool()->reuse(textures[i].path).id, textures[i].type };
+			return next_ >= textures.size();
+		}
+
+		ScopedLoadTimer timer{ LoadPhase::TextureUpload, textures[i].path };
+
+		glGenTextures(1, (GLuint*)&built_[i].id);
+		built_[i].type = textures[i].type;
+
+		// all upcoming GL_TEXTURE_2D operations now have effect on this texture object
+		glBindTexture(GL_TEXTURE_2D, built_[i].id);
+		// set the texture wrapping parameters
+		// set texture wrapping to GL_REPEAT (default wrapping method)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textures[i].wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textures[i].wrap);
+		// set texture filtering parameters
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, textures[i].min_filtering);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, textures[i].mag_filtering);
+
+		// decoded before another builder uploaded the same path
+		auto decoded = std::move(decoded_[i]);
+
+		if (!decoded)
+			decoded = context.getTexture2DPool()->decode(textures[i]);
+
+		static const DecodedImage missing{};
+		const DecodedImage& image = decoded ? *decoded : missing;
+
+		GLenum format = GL_RED;
+		if (image.channels == 1)
+			format = GL_RED;
+		else if (image.channels == 3)
+			format = GL_RGB;
+		else if (image.channels == 4)
+			format = GL_RGBA;
+
+		size_t bytes = 0;
+
+		// rows of RGB textures are not 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		if (image.isCompressed()) {
+			uploadCompressed(image.compressed, staging);
+			bytes = image.compressed.bytes();
+			timer.addBytesUploaded(bytes);
+		}
+		else if (image.pixels) {
+			const void* pixels = staging ? staging->stage(image.pixels, image.bytes()) : image.pixels;
+			glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format , GL_UNSIGNED_BYTE, pixels);
+			timer.addBytesUploaded(image.bytes());
+			glGenerateMipmap(GL_TEXTURE_2D);
+
+			if (staging)
+				staging->unbind();
+
+			// drivers pad RGB to 4 bytes per texel, the mips add a third
+			bytes = (size_t)image.width * image.height * (image.channels == 3 ? 4 : image.channels) * 4 / 3;
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		context.getTexture2DPool()->insert(textures[i].path, built_[i], bytes, image.isCompressed());
+
+		return next_ >= textures.size();
+	}
+
+	Texture2DGroup Texture2DGroupBuilder::build(StagingBuffer* staging) {
+		while (!uploadNext(staging)) {}
+
+		Texture2DGroup tex_group{};
+		tex_group.setTextures(std::move(built_));
+
+		// the pixels are on the GPU now
+		built_ = {};
+		next_ = 0;
+		decoded_.clear();
+		decoded_all_ = false;
 
 		return tex_group;
 	}
-}
\ No newline at end of file
+}
+namespace dlb {
+	uint Texture2DArrayPacker::add(const std::string& path) {
+		auto it = slots_.find(path);
+
+		if (it != slots_.end())
+			return it->second;
+
+		uint slot = paths_.size();
+		paths_.push_back(path);
+		slots_.insert({ path, slot });
+		return slot;
+	}
+
+	/*
+	* Copies `img` into `dst` at (x, y) surrounded by `pad` texels of its own
+	* clamped edges so mipmapping does not bleed neighbouring atlas entries.
+	*/
+	static void blitPadded(unsigned char* dst, int dst_size, int x, int y, int pad, const DecodedImage& img) {
+		for (int row = -pad; row < img.height + pad; row++) {
+			int src_row = std::clamp(row, 0, img.height - 1);
+
+			for (int col = -pad; col < img.width + pad; col++) {
+				int src_col = std::clamp(col, 0, img.width - 1);
+
+				const unsigned char* src = img.pixels + (src_row * img.width + src_col) * 4;
+				unsigned char* out = dst + ((y + pad + row) * dst_size + (x + pad + col)) * 4;
+				memcpy(out, src, 4);
+			}
+		}
+	}
+
+	// clamped edge texels around every atlas entry
+	static constexpr int ATLAS_PAD = 4;
+
+	static GLuint createArray(int width, int height, int layers) {
+		GLuint id;
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		return id;
+	}
+
+	void Texture2DArrayPacker::decode() {
+		PROFILE_ZONE("Texture2DArrayPacker::decode");
+
+		images_.resize(paths_.size());
+
+		ThreadPool::getInstance().parallelFor(paths_.size(), 1, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++) {
+				if (!images_[i].pixels)
+					images_[i].load(paths_[i], STBI_rgb_alpha);
+			}
+		});
+	}
+
+	void Texture2DArrayPacker::plan() {
+		PROFILE_ZONE("Texture2DArrayPacker::plan");
+
+		layers_.assign(paths_.size(), {});
+
+		decode();
+
+		auto& images = images_;
+
+		/*
+		* Group the big textures by size, the small ones go to the atlas.
+		*/
+		std::map<std::pair<int, int>, std::vector<uint>> groups{};
+		std::vector<uint> small{};
+
+		for (uint i = 0; i < images.size(); i++) {
+			if (!images[i].pixels)
+				continue;
+
+			// padded larger than a page, it gets an array of its own size
+			const bool fits_page = images[i].width + 2 * ATLAS_PAD <= atlas_size_ && images[i].height + 2 * ATLAS_PAD <= atlas_size_;
+
+			if (images[i].width <= atlas_threshold_ && images[i].height <= atlas_threshold_ && fits_page)
+				small.push_back(i);
+			else
+				groups[{ images[i].width, images[i].height }].push_back(i);
+		}
+
+		GLint layer_limit = 0;
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layer_limit);
+		const size_t max_layers = std::max(layer_limit, 1);
+
+		glActiveTexture(GL_TEXTURE0);
+
+		for (auto& [dims, members] : groups) {
+			// the rest of the sizes stay unpacked
+			if (set_.arrays_.size() == Texture2DArraySet::MAX_ARRAYS - (small.empty() ? 0 : 1))
+				break;
+
+			if (members.size() > max_layers)
+				members.resize(max_layers);
+
+			const uint array = set_.arrays_.size();
+			set_.arrays_.push_back(createArray(dims.first, dims.second, members.size()));
+
+			for (uint layer = 0; layer < members.size(); layer++) {
+				const auto& image = images[members[layer]];
+				uploads_.push_back({ array, layer, dims.first, dims.second, image.pixels, image.bytes(), layer + 1 == members.size() });
+				layers_[members[layer]] = { (int)array, (int)layer };
+			}
+		}
+
+		if (!small.empty()) {
+			const int pad = ATLAS_PAD;
+
+			// tallest first gives denser shelves
+			std::sort(small.begin(), small.end(), [&](uint a, uint b) {
+				return images[a].height > images[b].height;
+			});
+
+			struct Shelf {
+				int y, height, x;
+			};
+
+			auto& pages = pages_;
+			std::vector<std::vector<Shelf>> shelves{};
+
+			const uint array = set_.arrays_.size();
+
+			for (uint idx : small) {
+				const auto& img = images[idx];
+				int w = img.width + 2 * pad;
+				int h = img.height + 2 * pad;
+
+				int page = -1;
+				Shelf* target = nullptr;
+
+				for (size_t p = 0; p < pages.size() && !target; p++) {
+					for (auto& shelf : shelves[p]) {
+						if (h <= shelf.height && shelf.x + w <= atlas_size_) {
+							page = p;
+							target = &shelf;
+							break;
+						}
+					}
+
+					if (!target) {
+						int next_y = shelves[p].empty() ? 0 : shelves[p].back().y + shelves[p].back().height;
+
+						if (next_y + h <= atlas_size_) {
+							shelves[p].push_back({ next_y, h, 0 });
+							page = p;
+							target = &shelves[p].back();
+						}
+					}
+				}
+
+				if (!target) {
+					if (pages.size() == max_layers)
+						continue;
+
+					pages.emplace_back(atlas_size_ * atlas_size_ * 4, 0);
+					shelves.push_back({ { 0, h, 0 } });
+					page = pages.size() - 1;
+					target = &shelves.back().back();
+				}
+
+				blitPadded(pages[page].data(), atlas_size_, target->x, target->y, pad, img);
+
+				float inv = 1.0f / atlas_size_;
+				layers_[idx] = {
+					(int)array,
+					page,
+					glm::vec4((target->x + pad) * inv, (target->y + pad) * inv, img.width * inv, img.height * inv),
+				};
+
+				target->x += w;
+			}
+
+			set_.arrays_.push_back(createArray(atlas_size_, atlas_size_, pages.size()));
+
+			for (uint p = 0; p < pages.size(); p++)
+				uploads_.push_back({ array, p, atlas_size_, atlas_size_, pages[p].data(), pages[p].size(), p + 1 == pages.size() });
+		}
+
+		planned_ = true;
+	}
+
+	bool Texture2DArrayPacker::uploadNext(StagingBuffer* staging) {
+		if (!planned_)
+			plan();
+
+		if (next_upload_ >= uploads_.size())
+			return true;
+
+		const auto& upload = uploads_[next_upload_++];
+
+		// the model is not known here, every packer adds up to one entry
+		ScopedLoadTimer timer{ LoadPhase::TextureUpload, "texture arrays" };
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, set_.arrays_[upload.array]);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		const void* pixels = staging ? staging->stage(upload.pixels, upload.bytes) : upload.pixels;
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, upload.layer, upload.width, upload.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		timer.addBytesUploaded(upload.bytes);
+
+		if (staging)
+			staging->unbind();
+
+		// every layer of the array is in place
+		if (upload.last_layer)
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		return next_upload_ >= uploads_.size();
+	}
+
+	Texture2DArraySet Texture2DArrayPacker::build(StagingBuffer* staging) {
+		PROFILE_ZONE("Texture2DArrayPacker::build");
+
+		while (!uploadNext(staging)) {}
+
+		Texture2DArraySet set = std::move(set_);
+
+		// the pixels are on the GPU now
+		images_.clear();
+		pages_.clear();
+		uploads_.clear();
+		next_upload_ = 0;
+		planned_ = false;
+
+		return set;
+	}
+}
@@ -0,0 +1,96 @@
+#include <iostream>
+
+#include "assets/AssetStreamer.hpp"
+#include "jobs/ThreadPool.hpp"
+#include "Texture.hpp"
+#include "profiling/CpuProfiler.hpp"
+#include "profiling/FrameStats.hpp"
+
+namespace dlb {
+	AssetStreamer::~AssetStreamer() {
+		// the jobs write into the models and the queue
+		waitImports();
+	}
+
+	void AssetStreamer::request(scene::Model* model) {
+		pending_.fetch_add(1, std::memory_order_relaxed);
+
+		std::lock_guard lock{ mutex_ };
+
+		imports_.push_back(ThreadPool::getInstance().submit([this, model] {
+			model->import();
+
+			std::lock_guard lock{ mutex_ };
+			imported_.push_back(model);
+		}));
+	}
+
+	uint AssetStreamer::update(double budget_ms) {
+		PROFILE_ZONE("AssetStreamer::update");
+
+		const u64 deadline = FrameStats::nowNs() + (u64)(budget_ms * 1e6);
+
+		{
+			std::lock_guard lock{ mutex_ };
+			uploading_.insert(uploading_.end(), imported_.begin(), imported_.end());
+			imported_.clear();
+
+			// finished jobs, only the running ones need waiting for
+			std::erase_if(imports_, [](const std::future<void>& import) {
+				return import.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			});
+		}
+
+		uint resident = 0;
+
+		// at least one slice per frame, so a tiny budget still makes progress
+		while (!uploading_.empty()) {
+			auto* model = uploading_.front();
+
+			if (!model->uploadSlice(&staging_, deadline))
+				break;
+
+			if (model->getState() == scene::ModelState::Failed)
+				std::cerr << "[STREAMER] Dropped a model that failed to import" << std::endl;
+			else
+				resident++;
+
+			uploading_.pop_front();
+			pending_.fetch_sub(1, std::memory_order_relaxed);
+
+			if (FrameStats::nowNs() >= deadline)
+				break;
+		}
+
+		// mips dropped under the texture budget come out of the same budget
+		Texture2DPool::getInstance().uploadDroppedMips(deadline);
+
+		return resident;
+	}
+
+	void AssetStreamer::finish() {
+		PROFILE_ZONE("AssetStreamer::finish");
+
+		waitImports();
+
+		while (pendingCount() > 0)
+			update(1e3);
+	}
+
+	void AssetStreamer::waitImports() {
+		std::vector<std::future<void>> imports{};
+
+		{
+			std::lock_guard lock{ mutex_ };
+			imports.swap(imports_);
+		}
+
+		for (auto& import : imports) {
+			// the caller helps instead of idling
+			while (import.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				if (!ThreadPool::getInstance().runPending())
+					import.wait();
+			}
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#include <imgui.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "ecs/EntityInspector.hpp"
+#include "profiling/FrameStats.hpp"
+#include "profiling/CpuProfiler.hpp"
+
+namespace ecs {
+	bool EntityInspector::matches(const EntityPool& pool, const Entity& entity) const {
+		if (entity.dead)
+			return false;
+
+		if (model_filter_ >= 0 && entity.model_id != (uint)model_filter_)
+			return false;
+
+		if (colliding_only_ && pool.getComponents(entity.id).debug.bb_color.r <= 0.0f)
+			return false;
+
+		// search matches a substring of the id
+		if (search_[0]) {
+			char id[16];
+			std::snprintf(id, sizeof(id), "%u", entity.id);
+
+			if (!std::strstr(id, search_))
+				return false;
+		}
+
+		return true;
+	}
+
+	void EntityInspector::rebuildIndex(const EntityPool& pool) {
+		PROFILE_ZONE("EntityInspector::rebuildIndex");
+
+		// clear keeps the capacity, only growing scenes allocate
+		rows_.clear();
+
+		for (const auto& entity : pool.getEntities())
+			if (matches(pool, entity))
+				rows_.push_back(entity.id);
+
+		last_refresh_ns_ = dlb::FrameStats::nowNs();
+		dirty_ = false;
+	}
+
+	void EntityInspector::draw(const EntityPool& pool) {
+		if (!ImGui::CollapsingHeader("Entities"))
+			return;
+
+		PROFILE_ZONE("EntityInspector::draw");
+
+		if (ImGui::InputText("Search id", search_, sizeof(search_), ImGuiInputTextFlags_CharsDecimal))
+			dirty_ = true;
+
+		if (ImGui::InputInt("Model", &model_filter_))
+			dirty_ = true;
+
+		if (ImGui::Checkbox("Colliding only", &colliding_only_))
+			dirty_ = true;
+
+		const u64 now = dlb::FrameStats::nowNs();
+
+		if (dirty_ || (now - last_refresh_ns_) / 1e9 >= refresh_interval_)
+			rebuildIndex(pool);
+
+		ImGui::Text("%d of %d entities", (int)rows_.size(), (int)pool.getEntities().size());
+
+		if (ImGui::BeginChild("entity_list", ImVec2(0.0f, 200.0f), true)) {
+			ImGuiListClipper clipper;
+			clipper.Begin(rows_.size());
+
+			while (clipper.Step()) {
+				for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+					uint id = rows_[row];
+					const auto& entity = pool.getEntities()[id];
+
+					char label[48];
+					std::snprintf(label, sizeof(label), "Entity %u (model %u)", id, entity.model_id);
+
+					if (ImGui::Selectable(label, selected_ == (int)id))
+						selected_ = id;
+				}
+			}
+		}
+		ImGui::EndChild();
+
+		drawDetails(pool);
+	}
+
+	void EntityInspector::drawDetails(const EntityPool& pool) {
+		if (selected_ < 0)
+			return;
+
+		const auto& entities = pool.getEntities();
+
+		if (selected_ >= (int)entities.size() || entities[selected_].dead) {
+			ImGui::Text("Entity %d is dead", selected_);
+			return;
+		}
+
+		const auto& entity = entities[selected_];
+		const auto& comp = pool.getComponents(entity.id);
+		const auto& mov = comp.movement;
+		const auto& aabb = dlb::ApplicationSingleton::getInstance().getModel(entity.model_id).getAABB();
+
+		ImGui::SeparatorText("Selected");
+		ImGui::Text("Entity %u, model %u, shader %u", entity.id, entity.model_id, entity.shader_id);
+		ImGui::Text("Position %.3f %.3f %.3f", mov.position.x, mov.position.y, mov.position.z);
+		ImGui::Text("Velocity %.3f %.3f %.3f", mov.velocity.x, mov.velocity.y, mov.velocity.z);
+		ImGui::Text("Acceleration %.3f %.3f %.3f", mov.acceleration.x, mov.acceleration.y, mov.acceleration.z);
+		ImGui::Text("AABB min %.3f %.3f %.3f", aabb.min.x + mov.position.x, aabb.min.y + mov.position.y, aabb.min.z + mov.position.z);
+		ImGui::Text("AABB max %.3f %.3f %.3f", aabb.max.x + mov.position.x, aabb.max.y + mov.position.y, aabb.max.z + mov.position.z);
+		ImGui::TextUnformatted(comp.debug.bb_color.r > 0.0f ? "Colliding" : "Not colliding");
+	}
+}
@@ -1,32 +1,44 @@
 #include <string>
-#include <fstream>
 #include <iostream>
 
 #include "FileReader.hpp"
+#include "VirtualFileSystem.hpp"
+#include "jobs/ThreadPool.hpp"
 
 namespace dlb {
-	std::string FileReader::read(const std::string& path) {
-		const auto read_size = std::size_t(4096);
-		std::ifstream file{ path, std::ios::binary | std::ios::ate };
-
-		if (!file.is_open()) {
-			std::cerr << "[FILEREADER] File not found: " << path << std::endl;
-			exit(-1);
+	const char* fileErrorString(FileError error) {
+		switch (error) {
+		case FileError::None: return "no error";
+		case FileError::NotFound: return "file not found";
+		case FileError::Unreadable: return "file is empty or can not be read";
 		}
 
-		std::streamsize file_size = file.tellg();
-		if (file_size <= 0) {
-			std::cerr << "[FILEREADER] File is empty or size can not be determined: " << path << std::endl;
-			exit(-1);
-		}
+		return "unknown error";
+	}
 
-		file.seekg(0, std::ios::beg);
-		auto out = std::string();
-		auto buf = std::string(read_size, '\0');
-		while (file.read(&buf[0], read_size)) {
-			out.append(buf, 0, file.gcount());
-		}
-		out.append(buf, 0, file.gcount());
-		return out;
+	FileView FileReader::open(const std::string& path) {
+		auto& vfs = VirtualFileSystem::getInstance();
+		FileView view{};
+
+		if (vfs.open(path, view.file_))
+			view.error_ = FileError::None;
+		else
+			view.error_ = vfs.exists(path) ? FileError::Unreadable : FileError::NotFound;
+
+		return view;
+	}
+
+	std::vector<FileView> FileReader::openBatch(std::span<const std::string> paths) {
+		std::vector<FileView> views(paths.size());
+
+		// the page-ins of every file overlap instead of faulting one file at a time on first access
+		ThreadPool::getInstance().parallelFor(paths.size(), 1, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++) {
+				views[i] = open(paths[i]);
+				views[i].prefetch();
+			}
+		});
+
+		return views;
 	}
-};
\ No newline at end of file
+}
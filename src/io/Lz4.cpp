@@ -0,0 +1,209 @@
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "Lz4.hpp"
+
+namespace dlb {
+	static constexpr size_t MIN_MATCH = 4;
+	// the last match starts at least MATCH_LIMIT bytes before the end
+	static constexpr size_t MATCH_LIMIT = 12;
+	// and the last LAST_LITERALS bytes are always literals
+	static constexpr size_t LAST_LITERALS = 5;
+	static constexpr size_t MAX_OFFSET = 65535;
+	static constexpr int HASH_BITS = 16;
+
+	static uint32_t read32(const unsigned char* p) {
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	static uint32_t hash32(uint32_t sequence) {
+		return (sequence * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	/*
+	* Bytes of the length continuation of a token field, `length` is what is
+	* left after the 15 of the field.
+	*/
+	static size_t lengthBytes(size_t length) {
+		return length / 255 + 1;
+	}
+
+	static unsigned char* writeLength(unsigned char* out, size_t length) {
+		while (length >= 255) {
+			*out++ = 255;
+			length -= 255;
+		}
+
+		*out++ = (unsigned char)length;
+		return out;
+	}
+
+	/*
+	* Token, literals and (unless `match_length` is 0) offset and match
+	* length, returns nullptr when it does not fit.
+	*/
+	static unsigned char* writeSequence(unsigned char* out, const unsigned char* end, const unsigned char* literals, size_t literal_length, size_t offset, size_t match_length) {
+		size_t needed = 1 + literal_length;
+
+		if (literal_length >= 15)
+			needed += lengthBytes(literal_length - 15);
+
+		if (match_length) {
+			needed += 2;
+
+			if (match_length - MIN_MATCH >= 15)
+				needed += lengthBytes(match_length - MIN_MATCH - 15);
+		}
+
+		if (needed > (size_t)(end - out))
+			return nullptr;
+
+		unsigned char* token = out++;
+		*token = (unsigned char)(std::min<size_t>(literal_length, 15) << 4);
+
+		if (literal_length >= 15)
+			out = writeLength(out, literal_length - 15);
+
+		std::memcpy(out, literals, literal_length);
+		out += literal_length;
+
+		if (!match_length)
+			return out;
+
+		*out++ = (unsigned char)(offset & 0xFF);
+		*out++ = (unsigned char)(offset >> 8);
+
+		*token |= (unsigned char)std::min<size_t>(match_length - MIN_MATCH, 15);
+
+		if (match_length - MIN_MATCH >= 15)
+			out = writeLength(out, match_length - MIN_MATCH - 15);
+
+		return out;
+	}
+
+	size_t lz4Compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) {
+		unsigned char* out = dst;
+		const unsigned char* end = dst + capacity;
+
+		size_t anchor = 0;
+
+		if (size > MATCH_LIMIT) {
+			// last position seen for every hash of 4 bytes
+			std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+
+			const size_t match_start_limit = size - MATCH_LIMIT;
+			const size_t match_end_limit = size - LAST_LITERALS;
+
+			size_t pos = 0;
+
+			while (pos < match_start_limit) {
+				const uint32_t sequence = read32(src + pos);
+				uint32_t& slot = table[hash32(sequence)];
+				const size_t candidate = slot;
+				slot = (uint32_t)pos;
+
+				// a stale or empty slot is caught by the comparison
+				if (candidate >= pos || pos - candidate > MAX_OFFSET || read32(src + candidate) != sequence) {
+					pos++;
+					continue;
+				}
+
+				size_t length = MIN_MATCH;
+
+				while (pos + length < match_end_limit && src[candidate + length] == src[pos + length])
+					length++;
+
+				out = writeSequence(out, end, src + anchor, pos - anchor, pos - candidate, length);
+
+				if (!out)
+					return 0;
+
+				pos += length;
+				anchor = pos;
+			}
+		}
+
+		out = writeSequence(out, end, src + anchor, size - anchor, 0, 0);
+
+		return out ? out - dst : 0;
+	}
+
+	static bool readLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+		unsigned char byte;
+
+		do {
+			if (in >= end)
+				return false;
+
+			byte = *in++;
+			length += byte;
+		} while (byte == 255);
+
+		return true;
+	}
+
+	bool lz4Decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t dst_size) {
+		const unsigned char* in = src;
+		const unsigned char* in_end = src + size;
+		unsigned char* out = dst;
+		unsigned char* out_end = dst + dst_size;
+
+		while (in < in_end) {
+			const unsigned token = *in++;
+
+			size_t literal_length = token >> 4;
+
+			if (literal_length == 15 && !readLength(in, in_end, literal_length))
+				return false;
+
+			if (literal_length > (size_t)(in_end - in) || literal_length > (size_t)(out_end - out))
+				return false;
+
+			std::memcpy(out, in, literal_length);
+			in += literal_length;
+			out += literal_length;
+
+			// the last sequence has no match
+			if (in == in_end)
+				break;
+
+			if (in_end - in < 2)
+				return false;
+
+			const size_t offset = in[0] | (in[1] << 8);
+			in += 2;
+
+			if (offset == 0 || offset > (size_t)(out - dst))
+				return false;
+
+			size_t match_length = token & 15;
+
+			if (match_length == 15 && !readLength(in, in_end, match_length))
+				return false;
+
+			match_length += MIN_MATCH;
+
+			if (match_length > (size_t)(out_end - out))
+				return false;
+
+			const unsigned char* match = out - offset;
+
+			// overlapping matches repeat the last `offset` bytes
+			if (offset >= match_length) {
+				std::memcpy(out, match, match_length);
+			}
+			else {
+				for (size_t i = 0; i < match_length; i++)
+					out[i] = match[i];
+			}
+
+			out += match_length;
+		}
+
+		return out == out_end;
+	}
+}
@@ -0,0 +1,171 @@
+#include <iostream>
+#include <utility>
+#include <cstdint>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.hpp"
+
+namespace dlb {
+	MappedFile::~MappedFile() {
+		close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& x) noexcept {
+		*this = std::move(x);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& x) noexcept {
+		std::swap(data_, x.data_);
+		std::swap(size_, x.size_);
+		std::swap(mapped_, x.mapped_);
+		std::swap(storage_, x.storage_);
+#ifdef _WIN32
+		std::swap(file_, x.file_);
+		std::swap(mapping_, x.mapping_);
+#endif
+		return *this;
+	}
+
+	void MappedFile::borrow(const unsigned char* data, size_t size) {
+		close();
+
+		data_ = data;
+		size_ = size;
+	}
+
+	void MappedFile::prefetch() const {
+		// borrowed ranges point into a mapping as well
+		if (!data_ || !storage_.empty())
+			return;
+
+#ifdef _WIN32
+		WIN32_MEMORY_RANGE_ENTRY range{ (void*)data_, size_ };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+		// madvise wants a page aligned start
+		const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+		const uintptr_t begin = (uintptr_t)data_ & ~(page - 1);
+
+		madvise((void*)begin, (uintptr_t)data_ + size_ - begin, MADV_WILLNEED);
+#endif
+	}
+
+	void MappedFile::adopt(std::vector<unsigned char>&& bytes) {
+		close();
+
+		storage_ = std::move(bytes);
+		data_ = storage_.data();
+		size_ = storage_.size();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::string& path) {
+		close();
+
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size{};
+
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			std::cerr << "[MAPPEDFILE] File is empty or size can not be determined: " << path << std::endl;
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+		if (!view) {
+			std::cerr << "[MAPPEDFILE] Could not map " << path << ", error " << GetLastError() << std::endl;
+
+			if (mapping)
+				CloseHandle(mapping);
+
+			CloseHandle(file);
+			return false;
+		}
+
+		file_ = file;
+		mapping_ = mapping;
+		data_ = (const unsigned char*)view;
+		size_ = (size_t)size.QuadPart;
+		mapped_ = true;
+
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (data_ && mapped_)
+			UnmapViewOfFile(data_);
+
+		if (mapping_)
+			CloseHandle(mapping_);
+
+		if (file_)
+			CloseHandle(file_);
+
+		data_ = nullptr;
+		mapping_ = nullptr;
+		file_ = nullptr;
+		size_ = 0;
+		mapped_ = false;
+		std::vector<unsigned char>{}.swap(storage_);
+	}
+#else
+	bool MappedFile::open(const std::string& path) {
+		close();
+
+		int fd = ::open(path.c_str(), O_RDONLY);
+
+		if (fd < 0)
+			return false;
+
+		struct stat info{};
+
+		if (fstat(fd, &info) != 0 || info.st_size == 0) {
+			std::cerr << "[MAPPEDFILE] File is empty or size can not be determined: " << path << std::endl;
+			::close(fd);
+			return false;
+		}
+
+		void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		// the mapping keeps its own reference to the file
+		::close(fd);
+
+		if (view == MAP_FAILED) {
+			std::cerr << "[MAPPEDFILE] Could not map " << path << std::endl;
+			return false;
+		}
+
+		data_ = (const unsigned char*)view;
+		size_ = (size_t)info.st_size;
+		mapped_ = true;
+
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (data_ && mapped_)
+			munmap((void*)data_, size_);
+
+		data_ = nullptr;
+		size_ = 0;
+		mapped_ = false;
+		std::vector<unsigned char>{}.swap(storage_);
+	}
+#endif
+}
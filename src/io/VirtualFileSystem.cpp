@@ -0,0 +1,175 @@
+#include <iostream>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+
+#include "VirtualFileSystem.hpp"
+#include "Lz4.hpp"
+
+namespace dlb {
+	// LZ4 expands a byte to at most 255, a larger claimed size is corrupt
+	static constexpr u64 LZ4_MAX_RATIO = 255;
+
+	void VirtualFileSystem::mountDirectory(const std::string& root) {
+		root_ = root;
+
+		if (!root_.empty() && root_.back() != '/' && root_.back() != '\\')
+			root_ += '/';
+	}
+
+	bool VirtualFileSystem::mountPack(const std::string& path) {
+		entries_ = nullptr;
+		strings_ = nullptr;
+		header_ = {};
+
+		if (!pack_.open(path)) {
+			std::cerr << "[VFS] Could not open pack " << path << std::endl;
+			return false;
+		}
+
+		const u64 size = pack_.size();
+		PackHeader header{};
+
+		if (size < sizeof(header)) {
+			std::cerr << "[VFS] " << path << " is not a pack" << std::endl;
+			pack_.close();
+			return false;
+		}
+
+		std::memcpy(&header, pack_.data(), sizeof(header));
+
+		const bool valid_header = std::memcmp(header.magic, PACK_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+			header.version == PACK_FILE_VERSION &&
+			header.index_offset % alignof(PackEntry) == 0 &&
+			header.index_offset <= size && (u64)header.entry_count * sizeof(PackEntry) <= size - header.index_offset &&
+			header.strings_offset <= size && header.strings_size <= size - header.strings_offset;
+
+		if (!valid_header) {
+			std::cerr << "[VFS] " << path << " is not a pack or was written by another version" << std::endl;
+			pack_.close();
+			return false;
+		}
+
+		const auto* entries = (const PackEntry*)(pack_.data() + header.index_offset);
+
+		// every range is checked once here, lookups trust the index afterwards
+		for (uint i = 0; i < header.entry_count; i++) {
+			const auto& entry = entries[i];
+
+			const bool valid = entry.offset <= size && entry.stored_size <= size - entry.offset &&
+				((entry.flags & PackLz4) ? entry.size <= entry.stored_size * LZ4_MAX_RATIO : entry.stored_size == entry.size) &&
+				(u64)entry.path_offset + entry.path_length <= header.strings_size &&
+				(i == 0 || entries[i - 1].hash <= entry.hash);
+
+			if (!valid) {
+				std::cerr << "[VFS] " << path << " is corrupt, entry " << i << std::endl;
+				pack_.close();
+				return false;
+			}
+		}
+
+		header_ = header;
+		entries_ = entries;
+		strings_ = (const char*)pack_.data() + header.strings_offset;
+
+		std::cout << "[VFS] Mounted " << path << ", " << header.entry_count << " entries" << std::endl;
+		return true;
+	}
+
+	std::string VirtualFileSystem::normalize(std::string_view path) {
+		if (isLogical(path))
+			path.remove_prefix(SCHEME.size());
+
+		std::vector<std::string_view> parts{};
+
+		while (!path.empty()) {
+			const size_t end = std::min(path.find('/'), path.find('\\'));
+			const std::string_view part = path.substr(0, end);
+
+			if (part == "..") {
+				if (!parts.empty())
+					parts.pop_back();
+			}
+			else if (!part.empty() && part != ".") {
+				parts.push_back(part);
+			}
+
+			path.remove_prefix(end == std::string_view::npos ? path.size() : end + 1);
+		}
+
+		std::string normalized{};
+
+		for (const auto& part : parts) {
+			if (!normalized.empty())
+				normalized += '/';
+
+			normalized += part;
+		}
+
+		return normalized;
+	}
+
+	std::string VirtualFileSystem::resolve(const std::string& path) const {
+		if (!isLogical(path))
+			return path;
+
+		return root_ + normalize(path);
+	}
+
+	const PackEntry* VirtualFileSystem::find(const std::string& path) const {
+		if (!entries_ || !isLogical(path))
+			return nullptr;
+
+		const std::string key = normalize(path);
+		const u64 hash = hashPackPath(key);
+
+		const PackEntry* end = entries_ + header_.entry_count;
+		const PackEntry* entry = std::lower_bound(entries_, end, hash, [](const PackEntry& entry, u64 hash) {
+			return entry.hash < hash;
+		});
+
+		for (; entry != end && entry->hash == hash; entry++) {
+			if (std::string_view(strings_ + entry->path_offset, entry->path_length) == key)
+				return entry;
+		}
+
+		return nullptr;
+	}
+
+	bool VirtualFileSystem::isPacked(const std::string& path) const {
+		return find(path) != nullptr;
+	}
+
+	bool VirtualFileSystem::exists(const std::string& path) const {
+		if (isPacked(path))
+			return true;
+
+		std::error_code error{};
+		return std::filesystem::exists(resolve(path), error);
+	}
+
+	bool VirtualFileSystem::open(const std::string& path, MappedFile& file) const {
+		const PackEntry* entry = find(path);
+
+		if (!entry)
+			return file.open(resolve(path));
+
+		const unsigned char* stored = pack_.data() + entry->offset;
+
+		if (!(entry->flags & PackLz4)) {
+			file.borrow(stored, entry->size);
+			return true;
+		}
+
+		std::vector<unsigned char> bytes(entry->size);
+
+		if (!lz4Decompress(stored, entry->stored_size, bytes.data(), bytes.size())) {
+			std::cerr << "[VFS] Could not decompress " << path << std::endl;
+			return false;
+		}
+
+		file.adopt(std::move(bytes));
+		return true;
+	}
+}
@@ -0,0 +1,114 @@
+#include "jobs/ThreadPool.hpp"
+
+namespace dlb {
+	ThreadPool::ThreadPool(uint workers) {
+		for (uint i = 0; i < workers; i++)
+			workers_.emplace_back([this] { workerLoop(); });
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			stop_ = true;
+		}
+
+		cv_.notify_all();
+
+		for (auto& worker : workers_)
+			worker.join();
+	}
+
+	void ThreadPool::push(std::function<void()>&& job) {
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			jobs_.push_back(std::move(job));
+		}
+
+		cv_.notify_one();
+	}
+
+	bool ThreadPool::runPending() {
+		std::function<void()> job;
+
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+
+			if (jobs_.empty())
+				return false;
+
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+
+		job();
+		return true;
+	}
+
+	void ThreadPool::workerLoop() {
+		for (;;) {
+			std::function<void()> job;
+
+			{
+				std::unique_lock<std::mutex> lock{ mutex_ };
+				cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+
+				if (stop_ && jobs_.empty())
+					return;
+
+				job = std::move(jobs_.front());
+				jobs_.pop_front();
+			}
+
+			job();
+		}
+	}
+
+	void ThreadPool::parallelFor(uint count, uint grain, const std::function<void(uint, uint)>& fn) {
+		if (count == 0)
+			return;
+
+		grain = std::max(1u, grain);
+
+		uint chunks = std::min<uint>((count + grain - 1) / grain, workerCount() + 1);
+		uint chunk_size = (count + chunks - 1) / chunks;
+
+		if (chunks <= 1) {
+			fn(0, count);
+			return;
+		}
+
+		// outlives the call, a helper may only get to run after every chunk is done
+		struct Range {
+			std::atomic<uint> next{ 0 };
+			std::atomic<uint> done{ 0 };
+		};
+
+		auto range = std::make_shared<Range>();
+
+		// claims chunks until none is left, `fn` is only touched while the caller waits
+		auto work = [range, &fn, count, chunks, chunk_size] {
+			for (uint c = range->next.fetch_add(1, std::memory_order_relaxed); c < chunks; c = range->next.fetch_add(1, std::memory_order_relaxed)) {
+				uint begin = c * chunk_size;
+				uint end = std::min(count, begin + chunk_size);
+
+				if (begin < end)
+					fn(begin, end);
+
+				range->done.fetch_add(1, std::memory_order_release);
+			}
+		};
+
+		for (uint c = 1; c < chunks; c++)
+			push(work);
+
+		work();
+
+		/*
+		* Only our own chunks are run here, never other queued jobs: a long
+		*	import must not stall a frame, and a job holding a promise must
+		*	not end up waiting on itself.
+		*/
+		while (range->done.load(std::memory_order_acquire) != chunks)
+			std::this_thread::yield();
+	}
+}
@@ -0,0 +1,97 @@
+#include <glad/glad.h>
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <format>
+
+#include "platform/Benchmark.hpp"
+
+namespace dlb {
+	BenchmarkRecorder::~BenchmarkRecorder() {
+		if (queries_[0])
+			glDeleteQueries(QUERY_LATENCY, queries_);
+	}
+
+	void BenchmarkRecorder::beginFrame() {
+		if (!queries_[0])
+			glGenQueries(QUERY_LATENCY, queries_);
+
+		int slot = frames_.size() % QUERY_LATENCY;
+
+		// the slot is reused, its result from QUERY_LATENCY frames ago must be read first
+		if (query_frame_[slot] >= 0)
+			collect(false);
+
+		glBeginQuery(GL_TIME_ELAPSED, queries_[slot]);
+		query_frame_[slot] = frames_.size();
+
+		frames_.push_back({});
+		frame_start_ = std::chrono::steady_clock::now();
+	}
+
+	void BenchmarkRecorder::endFrame() {
+		glEndQuery(GL_TIME_ELAPSED);
+
+		auto elapsed = std::chrono::steady_clock::now() - frame_start_;
+		frames_.back().cpu_ms = std::chrono::duration<double, std::milli>(elapsed).count();
+	}
+
+	void BenchmarkRecorder::collect(bool wait) {
+		for (int slot = 0; slot < QUERY_LATENCY; slot++) {
+			if (query_frame_[slot] < 0)
+				continue;
+
+			GLint available = GL_FALSE;
+
+			if (!wait)
+				glGetQueryObjectiv(queries_[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+
+			// oldest queries are done long before the slot comes around again
+			if (wait || available || (long long)frames_.size() - query_frame_[slot] >= QUERY_LATENCY) {
+				GLuint64 ns = 0;
+				glGetQueryObjectui64v(queries_[slot], GL_QUERY_RESULT, &ns);
+				frames_[query_frame_[slot]].gpu_ms = ns / 1e6;
+				query_frame_[slot] = -1;
+			}
+		}
+	}
+
+	bool BenchmarkRecorder::writeCSV(const std::string& path) {
+		collect(true);
+
+		std::ofstream file{ path };
+
+		if (!file.is_open()) {
+			std::cerr << "[BENCHMARK] Can not write " << path << std::endl;
+			return false;
+		}
+
+		file << "frame,cpu_ms,gpu_ms\n";
+
+		for (size_t i = 0; i < frames_.size(); i++)
+			file << std::format("{},{:.4f},{:.4f}\n", i, frames_[i].cpu_ms, frames_[i].gpu_ms);
+
+		return true;
+	}
+
+	void BenchmarkRecorder::printSummary() {
+		collect(true);
+
+		if (frames_.empty())
+			return;
+
+		double cpu_total = 0.0, gpu_total = 0.0;
+		double cpu_max = 0.0, gpu_max = 0.0;
+
+		for (const auto& f : frames_) {
+			cpu_total += f.cpu_ms;
+			gpu_total += std::max(0.0, f.gpu_ms);
+			cpu_max = std::max(cpu_max, f.cpu_ms);
+			gpu_max = std::max(gpu_max, f.gpu_ms);
+		}
+
+		std::cout << std::format("[BENCHMARK] {} frames, CPU avg {:.3f} ms max {:.3f} ms, GPU avg {:.3f} ms max {:.3f} ms\n",
+			frames_.size(), cpu_total / frames_.size(), cpu_max, gpu_total / frames_.size(), gpu_max);
+	}
+}
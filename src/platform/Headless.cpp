@@ -0,0 +1,175 @@
+#include <glad/glad.h>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#ifdef DLB_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "platform/Headless.hpp"
+
+namespace dlb {
+	HeadlessContext::~HeadlessContext() {
+#ifdef DLB_HEADLESS_EGL
+		if (display_) {
+			// not deleted at shutdown, current again for the GL calls
+			if (context_ && fbo_ && eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_))
+				destroyFramebuffer();
+
+			eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+			if (context_)
+				eglDestroyContext(display_, context_);
+
+			eglTerminate(display_);
+		}
+#endif
+	}
+
+	bool HeadlessContext::create() {
+#ifdef DLB_HEADLESS_EGL
+		/*
+		* Prefer the surfaceless platform, it needs neither a display server
+		* nor a GPU device node.
+		*/
+		auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+		EGLDisplay display = EGL_NO_DISPLAY;
+
+		if (get_platform_display)
+			display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+		if (display == EGL_NO_DISPLAY)
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+		EGLint major, minor;
+
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+			std::cerr << "[HEADLESS] Can not initialize EGL" << std::endl;
+			return false;
+		}
+
+		display_ = display;
+
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			std::cerr << "[HEADLESS] EGL has no desktop OpenGL" << std::endl;
+			return false;
+		}
+
+		const EGLint config_attribs[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE,
+		};
+
+		EGLConfig config;
+		EGLint config_count = 0;
+		eglChooseConfig(display, config_attribs, &config, 1, &config_count);
+
+		const EGLint context_attribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE,
+		};
+
+		EGLContext context = eglCreateContext(display, config_count > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+
+		if (context == EGL_NO_CONTEXT) {
+			std::cerr << "[HEADLESS] Can not create a GL 3.3 core context" << std::endl;
+			return false;
+		}
+
+		context_ = context;
+
+		if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+			std::cerr << "[HEADLESS] Surfaceless contexts are not supported" << std::endl;
+			return false;
+		}
+
+		std::cout << "[HEADLESS] EGL " << major << "." << minor << " context created" << std::endl;
+		return true;
+#else
+		std::cerr << "[HEADLESS] Built without LEARNOPENGL_HEADLESS" << std::endl;
+		return false;
+#endif
+	}
+
+	void* HeadlessContext::getProcAddress([[maybe_unused]] const char* name) {
+#ifdef DLB_HEADLESS_EGL
+		return (void*)eglGetProcAddress(name);
+#else
+		return nullptr;
+#endif
+	}
+
+	bool HeadlessContext::makeCurrent([[maybe_unused]] bool current) {
+#ifdef DLB_HEADLESS_EGL
+		if (!display_)
+			return false;
+
+		return eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, current ? context_ : EGL_NO_CONTEXT);
+#else
+		return false;
+#endif
+	}
+
+	void HeadlessContext::createFramebuffer(int width, int height) {
+		width_ = width;
+		height_ = height;
+
+		glGenFramebuffers(1, &fbo_);
+		glGenRenderbuffers(1, &color_);
+		glGenRenderbuffers(1, &depth_);
+
+		glBindRenderbuffer(GL_RENDERBUFFER, color_);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cerr << "[HEADLESS] Offscreen framebuffer is incomplete" << std::endl;
+	}
+
+	void HeadlessContext::destroyFramebuffer() {
+		if (!fbo_)
+			return;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fbo_);
+		glDeleteRenderbuffers(1, &color_);
+		glDeleteRenderbuffers(1, &depth_);
+
+		fbo_ = color_ = depth_ = 0;
+	}
+
+	bool HeadlessContext::writePPM(const std::string& path) const {
+		std::vector<unsigned char> pixels(width_ * height_ * 3);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+		std::ofstream file{ path, std::ios::binary };
+
+		if (!file.is_open()) {
+			std::cerr << "[HEADLESS] Can not write " << path << std::endl;
+			return false;
+		}
+
+		file << "P6\n" << width_ << " " << height_ << "\n255\n";
+
+		// GL rows go bottom to top
+		for (int y = height_ - 1; y >= 0; y--)
+			file.write((const char*)&pixels[y * width_ * 3], width_ * 3);
+
+		return true;
+	}
+}
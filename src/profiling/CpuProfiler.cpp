@@ -0,0 +1,225 @@
+#include <imgui.h>
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <format>
+
+#include "profiling/CpuProfiler.hpp"
+
+namespace dlb {
+	CpuProfiler::CpuProfiler()
+		:ticks0_(profilerTicks()),
+		time0_(std::chrono::steady_clock::now()) {
+	}
+
+	CpuZoneBuffer& CpuProfiler::threadBuffer() {
+		thread_local CpuZoneBuffer* buffer = &getInstance().registerThread();
+		return *buffer;
+	}
+
+	CpuZoneBuffer& CpuProfiler::registerThread() {
+		std::lock_guard lock{ registry_mutex_ };
+
+		// buffers outlive their threads so the collector never reads freed memory
+		buffers_.push_back(std::make_unique<CpuZoneBuffer>());
+		buffers_.back()->thread_index = buffers_.size() - 1;
+		return *buffers_.back();
+	}
+
+	double CpuProfiler::ticksToNs(u64 ticks) const {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		// calibrate the TSC against steady_clock over the whole run time
+		u64 ticks_now = profilerTicks();
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time0_).count();
+
+		if (ticks_now <= ticks0_ || ns <= 0.0)
+			return 0.0;
+
+		return ticks * (ns / (ticks_now - ticks0_));
+#else
+		return (double)ticks;
+#endif
+	}
+
+	void CpuProfiler::beginFrame() {
+		frame_begin_ = profilerTicks();
+	}
+
+	void CpuProfiler::endFrame() {
+		frame_end_ = profilerTicks();
+		collect();
+
+		last_frame_.swap(current_frame_);
+		current_frame_.clear();
+		last_frame_begin_ = frame_begin_;
+		last_frame_end_ = frame_end_;
+	}
+
+	void CpuProfiler::collect() {
+		std::lock_guard lock{ registry_mutex_ };
+
+		for (auto& buffer : buffers_) {
+			u64 head = buffer->head.load(std::memory_order_acquire);
+
+			// the writer lapped us, skip what was overwritten
+			if (head - buffer->tail > CpuZoneBuffer::CAPACITY)
+				buffer->tail = head - CpuZoneBuffer::CAPACITY;
+
+			for (u64 i = buffer->tail; i < head; i++) {
+				ThreadZone zone{ buffer->events[i % CpuZoneBuffer::CAPACITY], buffer->thread_index };
+
+				// the slot may have been reused while copying it, at exactly CAPACITY the writer is on it
+				u64 written = buffer->head.load(std::memory_order_acquire);
+				if (written - i >= CpuZoneBuffer::CAPACITY)
+					continue;
+
+				if (zone.event.begin >= frame_begin_)
+					current_frame_.push_back(zone);
+
+				if (recording_ && recorded_.size() < MAX_RECORDED)
+					recorded_.push_back(zone);
+			}
+
+			buffer->tail = head;
+		}
+	}
+
+	void CpuProfiler::setRecording(bool value) {
+		if (value && !recording_)
+			recorded_.clear();
+
+		recording_ = value;
+	}
+
+	bool CpuProfiler::writeChromeTrace(const std::string& path) {
+		std::ofstream file{ path };
+
+		if (!file.is_open()) {
+			std::cerr << "[CPU PROFILER] Can not write " << path << std::endl;
+			return false;
+		}
+
+		file << "{\"traceEvents\":[\n";
+
+		bool first = true;
+		for (const auto& zone : recorded_) {
+			std::string name;
+			for (const char* c = zone.event.name; *c; c++) {
+				if (*c == '"' || *c == '\\')
+					name += '\\';
+				name += *c;
+			}
+
+			double ts = ticksToNs(zone.event.begin - ticks0_) / 1000.0;
+			double dur = ticksToNs(zone.event.end - zone.event.begin) / 1000.0;
+
+			file << std::format("{}{{\"name\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":0,\"tid\":{}}}",
+				first ? "" : ",\n", name, ts, dur, zone.thread_index);
+			first = false;
+		}
+
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		std::cout << "[CPU PROFILER] Wrote " << recorded_.size() << " zones to " << path << std::endl;
+		return true;
+	}
+
+	std::string CpuProfiler::hotPath(uint thread_index) const {
+		std::string path;
+		const CpuZoneEvent* parent = nullptr;
+
+		for (uint depth = 0;; depth++) {
+			const CpuZoneEvent* longest = nullptr;
+
+			for (const auto& zone : last_frame_) {
+				const auto& e = zone.event;
+
+				if (zone.thread_index != thread_index || e.depth != depth)
+					continue;
+
+				if (parent && (e.begin < parent->begin || e.end > parent->end))
+					continue;
+
+				if (!longest || e.end - e.begin > longest->end - longest->begin)
+					longest = &e;
+			}
+
+			if (!longest)
+				break;
+
+			// a child only explains the parent when it takes most of it
+			if (parent && (longest->end - longest->begin) * 2 < parent->end - parent->begin)
+				break;
+
+			if (!path.empty())
+				path += " > ";
+			path += longest->name;
+			parent = longest;
+		}
+
+		return path;
+	}
+
+	void CpuProfiler::drawImGui() {
+		if (!ImGui::CollapsingHeader("CPU Zones"))
+			return;
+
+		bool recording = recording_;
+		if (ImGui::Checkbox("Record Trace", &recording))
+			setRecording(recording);
+
+		ImGui::SameLine();
+		if (ImGui::Button("Export Chrome Trace"))
+			writeChromeTrace("cpu_trace.json");
+
+		if (last_frame_end_ <= last_frame_begin_)
+			return;
+
+		double frame_ns = ticksToNs(last_frame_end_ - last_frame_begin_);
+		ImGui::Text("Frame: %.3f ms, %d zones", frame_ns / 1e6, (int)last_frame_.size());
+
+		// flame graph: one lane per thread, one row per nesting depth
+		constexpr float ROW_HEIGHT = 18.0f;
+
+		uint thread_count = 0, max_depth = 0;
+		for (const auto& zone : last_frame_) {
+			thread_count = std::max(thread_count, zone.thread_index + 1);
+			max_depth = std::max(max_depth, zone.event.depth + 1);
+		}
+
+		float width = ImGui::GetContentRegionAvail().x;
+		float lane_height = max_depth * ROW_HEIGHT + 4.0f;
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImDrawList* draw_list = ImGui::GetWindowDrawList();
+
+		ImGui::InvisibleButton("cpu_flame_graph", ImVec2(width, std::max(1.0f, thread_count * lane_height)));
+		bool hovered = ImGui::IsItemHovered();
+		ImVec2 mouse = ImGui::GetMousePos();
+
+		for (const auto& zone : last_frame_) {
+			double begin = ticksToNs(zone.event.begin - last_frame_begin_) / frame_ns;
+			double end = ticksToNs(std::min(zone.event.end, last_frame_end_) - last_frame_begin_) / frame_ns;
+
+			ImVec2 min{ origin.x + (float)begin * width,
+				origin.y + zone.thread_index * lane_height + zone.event.depth * ROW_HEIGHT };
+			ImVec2 max{ std::max(min.x + 1.0f, origin.x + (float)end * width), min.y + ROW_HEIGHT - 1.0f };
+
+			// stable colour per zone name
+			u64 hash = std::hash<const void*>{}(zone.event.name);
+			ImU32 color = IM_COL32(90 + hash % 120, 90 + (hash >> 8) % 120, 90 + (hash >> 16) % 120, 255);
+
+			draw_list->AddRectFilled(min, max, color);
+
+			if (max.x - min.x > 30.0f) {
+				draw_list->PushClipRect(min, max, true);
+				draw_list->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32_WHITE, zone.event.name);
+				draw_list->PopClipRect();
+			}
+
+			if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+				ImGui::SetTooltip("%s\n%.3f ms (thread %u)", zone.event.name,
+					ticksToNs(zone.event.end - zone.event.begin) / 1e6, zone.thread_index);
+		}
+	}
+}
@@ -0,0 +1,210 @@
+#include <imgui.h>
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <format>
+
+#include "profiling/FrameStats.hpp"
+#include "profiling/CpuProfiler.hpp"
+
+namespace dlb {
+	namespace {
+		double percentileOf(std::vector<float>& values, float p) {
+			if (values.empty())
+				return 0.0;
+
+			size_t n = std::min(values.size() - 1, (size_t)(p * values.size()));
+			std::nth_element(values.begin(), values.begin() + n, values.end());
+			return values[n];
+		}
+	}
+
+	const char* FrameStats::phaseName(FramePhase phase) {
+		switch (phase) {
+		case FramePhase::Simulation: return "Simulation";
+		case FramePhase::RenderSubmit: return "Render Submit";
+		case FramePhase::Swap: return "Swap";
+		default: return "Frame";
+		}
+	}
+
+	void FrameStats::beginFrame() {
+		frame_begin_ = nowNs();
+	}
+
+	void FrameStats::endFrame() {
+		FrameSample sample{};
+		sample.ms[PHASE_COUNT] = (nowNs() - frame_begin_) / 1e6f;
+
+		// render thread phases land in the frame they finished in
+		for (uint i = 0; i < PHASE_COUNT; i++)
+			sample.ms[i] = phase_ns_[i].exchange(0, std::memory_order_relaxed) / 1e6f;
+
+		history_[head_] = sample;
+		head_ = (head_ + 1) % HISTORY;
+		count_ = std::min(count_ + 1, HISTORY);
+
+		session_.push_back(sample);
+
+		if (sample.ms[PHASE_COUNT] > hitch_threshold_ms_) {
+			uint slowest = 0;
+			for (uint i = 1; i < PHASE_COUNT; i++)
+				if (sample.ms[i] > sample.ms[slowest])
+					slowest = i;
+
+			auto& profiler = CpuProfiler::getInstance();
+			Hitch hitch{ frame_index_, sample.ms[PHASE_COUNT], (FramePhase)slowest,
+				profiler.hotPath(CpuProfiler::threadBuffer().thread_index) };
+
+			std::cout << std::format("[FRAME STATS] Hitch at frame {}: {:.2f} ms, {} {:.2f} ms, zone {}\n",
+				hitch.frame, hitch.ms, phaseName(hitch.phase), sample.ms[slowest],
+				hitch.zone.empty() ? "-" : hitch.zone);
+
+			if (hitches_.size() == MAX_HITCHES)
+				hitches_.erase(hitches_.begin());
+			hitches_.push_back(std::move(hitch));
+			hitch_count_++;
+		}
+
+		frame_index_++;
+	}
+
+	double FrameStats::percentile(FramePhase phase, float p) const {
+		std::vector<float> values(count_);
+
+		for (uint i = 0; i < count_; i++)
+			values[i] = history_[i].ms[(uint)phase];
+
+		return percentileOf(values, p);
+	}
+
+	double FrameStats::worst(FramePhase phase) const {
+		float result = 0.0f;
+
+		for (uint i = 0; i < count_; i++)
+			result = std::max(result, history_[i].ms[(uint)phase]);
+
+		return result;
+	}
+
+	double FrameStats::averageFrameMs() const {
+		if (count_ == 0)
+			return 0.0;
+
+		double total = 0.0;
+
+		for (uint i = 0; i < count_; i++)
+			total += history_[i].ms[PHASE_COUNT];
+
+		return total / count_;
+	}
+
+	void FrameStats::drawImGui() {
+		double avg = averageFrameMs();
+		ImGui::Text("FPS: %.1f (%.3f ms)", avg > 0.0 ? 1000.0 / avg : 0.0, avg);
+
+		if (!ImGui::CollapsingHeader("Frame Timing"))
+			return;
+
+		// oldest first
+		float plot[HISTORY];
+		uint first = count_ < HISTORY ? 0 : head_;
+		for (uint i = 0; i < count_; i++)
+			plot[i] = history_[(first + i) % HISTORY].ms[PHASE_COUNT];
+
+		ImGui::PlotLines("##frame_times", plot, count_, 0, "Frame ms", 0.0f,
+			(float)std::max(worst(FramePhase::Count), hitch_threshold_ms_), ImVec2(0.0f, 60.0f));
+
+		if (ImGui::BeginTable("frame_timing", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+			ImGui::TableSetupColumn("Phase");
+			ImGui::TableSetupColumn("p50");
+			ImGui::TableSetupColumn("p95");
+			ImGui::TableSetupColumn("p99");
+			ImGui::TableSetupColumn("worst");
+			ImGui::TableHeadersRow();
+
+			for (uint i = 0; i <= PHASE_COUNT; i++) {
+				// whole frame first
+				FramePhase phase = (FramePhase)((i + PHASE_COUNT) % (PHASE_COUNT + 1));
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(phaseName(phase));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", percentile(phase, 0.50f));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", percentile(phase, 0.95f));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", percentile(phase, 0.99f));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", worst(phase));
+			}
+
+			ImGui::EndTable();
+		}
+
+		float threshold = hitch_threshold_ms_;
+		if (ImGui::InputFloat("Hitch ms", &threshold, 1.0f))
+			hitch_threshold_ms_ = std::max(1.0f, threshold);
+
+		ImGui::Text("Hitches: %llu", (unsigned long long)hitch_count_);
+
+		for (auto it = hitches_.rbegin(); it != hitches_.rend(); it++)
+			ImGui::Text("#%llu %.2f ms %s %s", (unsigned long long)it->frame, it->ms,
+				phaseName(it->phase), it->zone.c_str());
+	}
+
+	std::string FrameStats::summary() const {
+		if (session_.empty())
+			return "";
+
+		std::string out = std::format("{} frames, {} hitches over {:.1f} ms\n",
+			session_.size(), hitch_count_, hitch_threshold_ms_);
+
+		std::vector<float> values(session_.size());
+
+		for (uint i = 0; i <= PHASE_COUNT; i++) {
+			FramePhase phase = (FramePhase)((i + PHASE_COUNT) % (PHASE_COUNT + 1));
+
+			double total = 0.0;
+			for (size_t f = 0; f < session_.size(); f++) {
+				values[f] = session_[f].ms[(uint)phase];
+				total += values[f];
+			}
+
+			double p50 = percentileOf(values, 0.50f);
+			double p95 = percentileOf(values, 0.95f);
+			double p99 = percentileOf(values, 0.99f);
+			double max = *std::max_element(values.begin(), values.end());
+
+			out += std::format("{:<14} avg {:8.3f} p50 {:8.3f} p95 {:8.3f} p99 {:8.3f} worst {:8.3f} ms\n",
+				phaseName(phase), total / session_.size(), p50, p95, p99, max);
+		}
+
+		for (const auto& hitch : hitches_)
+			out += std::format("hitch frame {} {:.2f} ms {} {}\n",
+				hitch.frame, hitch.ms, phaseName(hitch.phase), hitch.zone);
+
+		return out;
+	}
+
+	void FrameStats::printSummary() const {
+		std::string text = summary();
+
+		if (!text.empty())
+			std::cout << "[FRAME STATS] " << text;
+	}
+
+	bool FrameStats::writeSummary(const std::string& path) const {
+		std::ofstream file{ path };
+
+		if (!file.is_open()) {
+			std::cerr << "[FRAME STATS] Can not write " << path << std::endl;
+			return false;
+		}
+
+		file << summary();
+		return true;
+	}
+}
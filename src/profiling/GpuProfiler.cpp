@@ -0,0 +1,199 @@
+#include <glad/glad.h>
+
+#include <imgui.h>
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <format>
+
+#include "profiling/GpuProfiler.hpp"
+
+namespace dlb {
+	float GpuProfiler::PassStats::average() const {
+		if (count == 0)
+			return 0.0f;
+
+		float total = 0.0f;
+
+		for (uint i = 0; i < count; i++)
+			total += samples[i];
+
+		return total / count;
+	}
+
+	int GpuProfiler::passId(const char* name) {
+		std::lock_guard lock{ stats_mutex_ };
+
+		auto it = ids_.find(name);
+
+		if (it != ids_.end())
+			return it->second;
+
+		int id = passes_.size();
+		passes_.push_back({ name });
+		ids_.insert({ name, id });
+		return id;
+	}
+
+	void GpuProfiler::beginFrame() {
+		if (!enabled_)
+			return;
+
+		if (!initialized_) {
+			for (auto& frame : frames_)
+				glGenQueries(MAX_PASSES * 2, frame.queries);
+
+			initialized_ = true;
+		}
+
+		current_slot_ = frame_ % FRAME_LATENCY;
+
+		// FRAME_LATENCY frames old, the results are normally ready and this does not wait
+		if (frames_[current_slot_].pending)
+			resolve(current_slot_);
+
+		auto& frame = frames_[current_slot_];
+		frame.pass_count = 0;
+		frame.frame = frame_;
+		frame.pending = true;
+
+		stack_.clear();
+	}
+
+	void GpuProfiler::endFrame() {
+		if (!enabled_)
+			return;
+
+		assert(stack_.empty() && "Unbalanced GPU passes");
+
+		frame_++;
+	}
+
+	void GpuProfiler::beginPass(const char* name) {
+		if (!enabled_)
+			return;
+
+		auto& frame = frames_[current_slot_];
+
+		if (frame.pass_count == MAX_PASSES) {
+			// keep the stack balanced, the pass is just not measured
+			stack_.push_back(-1);
+			return;
+		}
+
+		int index = frame.pass_count++;
+		frame.pass_ids[index] = passId(name);
+		glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+
+		stack_.push_back(index);
+	}
+
+	void GpuProfiler::endPass() {
+		if (!enabled_)
+			return;
+
+		assert(!stack_.empty() && "endPass without beginPass");
+
+		int index = stack_.back();
+		stack_.pop_back();
+
+		if (index >= 0)
+			glQueryCounter(frames_[current_slot_].queries[index * 2 + 1], GL_TIMESTAMP);
+	}
+
+	void GpuProfiler::resolve(int slot) {
+		auto& frame = frames_[slot];
+
+		std::lock_guard lock{ stats_mutex_ };
+
+		for (int i = 0; i < frame.pass_count; i++) {
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+			auto& pass = passes_[frame.pass_ids[i]];
+			pass.samples[pass.head] = (end - begin) / 1e6f;
+			pass.frames[pass.head] = frame.frame;
+			pass.head = (pass.head + 1) % HISTORY;
+			pass.count = std::min<uint>(pass.count + 1, HISTORY);
+		}
+
+		frame.pending = false;
+	}
+
+	float GpuProfiler::percentile(const PassStats& pass, float p) {
+		if (pass.count == 0)
+			return 0.0f;
+
+		scratch_.assign(pass.samples, pass.samples + pass.count);
+
+		size_t n = std::min<size_t>(scratch_.size() - 1, (size_t)(p * scratch_.size()));
+		std::nth_element(scratch_.begin(), scratch_.begin() + n, scratch_.end());
+		return scratch_[n];
+	}
+
+	void GpuProfiler::drawImGui() {
+		if (!ImGui::CollapsingHeader("GPU Passes"))
+			return;
+
+		std::unique_lock lock{ stats_mutex_ };
+
+		if (ImGui::BeginTable("gpu_passes", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+			ImGui::TableSetupColumn("Pass");
+			ImGui::TableSetupColumn("avg ms");
+			ImGui::TableSetupColumn("p50");
+			ImGui::TableSetupColumn("p95");
+			ImGui::TableSetupColumn("p99");
+			ImGui::TableHeadersRow();
+
+			for (const auto& pass : passes_) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(pass.name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", pass.average());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", percentile(pass, 0.50f));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", percentile(pass, 0.95f));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", percentile(pass, 0.99f));
+			}
+
+			ImGui::EndTable();
+		}
+
+		lock.unlock();
+
+		if (ImGui::Button("Export GPU CSV"))
+			writeCSV("gpu_passes.csv");
+	}
+
+	bool GpuProfiler::writeCSV(const std::string& path) const {
+		std::ofstream file{ path };
+
+		if (!file.is_open()) {
+			std::cerr << "[GPU PROFILER] Can not write " << path << std::endl;
+			return false;
+		}
+
+		file << "frame,pass,ms\n";
+
+		std::lock_guard lock{ stats_mutex_ };
+
+		for (const auto& pass : passes_) {
+			// oldest sample first
+			uint first = pass.count < HISTORY ? 0 : pass.head;
+
+			for (uint i = 0; i < pass.count; i++) {
+				uint s = (first + i) % HISTORY;
+				file << std::format("{},{},{:.4f}\n", pass.frames[s], pass.name, pass.samples[s]);
+			}
+		}
+
+		std::cout << "[GPU PROFILER] Wrote " << path << std::endl;
+		return true;
+	}
+}
@@ -0,0 +1,195 @@
+#include <iostream>
+#include <fstream>
+#include <format>
+#include <algorithm>
+
+#include "profiling/LoadStats.hpp"
+#include "profiling/FrameStats.hpp"
+
+namespace dlb {
+	// taken during static initialization, before main
+	static const u64 process_start_ns = FrameStats::nowNs();
+
+	const char* LoadStats::phaseName(LoadPhase phase) {
+		switch (phase) {
+		case LoadPhase::Context: return "Context";
+		case LoadPhase::ShaderCompile: return "ShaderCompile";
+		case LoadPhase::ShaderLink: return "ShaderLink";
+		case LoadPhase::ModelImport: return "ModelImport";
+		case LoadPhase::TextureDecode: return "TextureDecode";
+		case LoadPhase::TextureUpload: return "TextureUpload";
+		case LoadPhase::BufferUpload: return "BufferUpload";
+		default: return "Unknown";
+		}
+	}
+
+	void LoadStats::record(LoadPhase phase, std::string_view name, u64 ns, u64 bytes_read, u64 bytes_uploaded) {
+		if (!isRecording())
+			return;
+
+		std::lock_guard lock{ mutex_ };
+
+		auto [it, inserted] = index_.try_emplace({ (uint)phase, std::string(name) }, items_.size());
+
+		if (inserted)
+			items_.push_back({ phase, std::string(name) });
+
+		auto& item = items_[it->second];
+		item.count++;
+		item.ns += ns;
+		item.bytes_read += bytes_read;
+		item.bytes_uploaded += bytes_uploaded;
+	}
+
+	std::vector<LoadStats::Item> LoadStats::sorted() const {
+		std::vector<Item> items{};
+
+		{
+			std::lock_guard lock{ mutex_ };
+			items = items_;
+		}
+
+		std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+			return a.ns > b.ns;
+		});
+
+		return items;
+	}
+
+	std::vector<LoadStats::Item> LoadStats::phaseTotals(const std::vector<Item>& items) const {
+		std::vector<Item> totals(PHASE_COUNT);
+
+		for (uint i = 0; i < PHASE_COUNT; i++)
+			totals[i].phase = (LoadPhase)i;
+
+		for (const auto& item : items) {
+			auto& total = totals[(uint)item.phase];
+			total.count += item.count;
+			total.ns += item.ns;
+			total.bytes_read += item.bytes_read;
+			total.bytes_uploaded += item.bytes_uploaded;
+		}
+
+		std::stable_sort(totals.begin(), totals.end(), [](const Item& a, const Item& b) {
+			return a.ns > b.ns;
+		});
+
+		return totals;
+	}
+
+	static double toMs(u64 ns) {
+		return ns / 1e6;
+	}
+
+	static double toMiB(u64 bytes) {
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	std::string LoadStats::report() const {
+		static constexpr size_t SLOWEST = 15;
+
+		const auto items = sorted();
+
+		std::string out = std::format("{:.1f} ms from process start to the first loaded frame\n", toMs(startup_ns_));
+		out += std::format("{:<14} {:>6} {:>10} {:>10} {:>12}\n", "phase", "steps", "ms", "read MiB", "uploaded MiB");
+
+		for (const auto& total : phaseTotals(items)) {
+			if (total.count == 0)
+				continue;
+
+			out += std::format("{:<14} {:>6} {:>10.1f} {:>10.2f} {:>12.2f}\n",
+				phaseName(total.phase), total.count, toMs(total.ns), toMiB(total.bytes_read), toMiB(total.bytes_uploaded));
+		}
+
+		out += "slowest:\n";
+
+		for (size_t i = 0; i < std::min(SLOWEST, items.size()); i++) {
+			const auto& item = items[i];
+			out += std::format("{:>10.1f} ms {:<14} {}", toMs(item.ns), phaseName(item.phase), item.name);
+
+			if (item.count > 1)
+				out += std::format(" x{}", item.count);
+
+			out += "\n";
+		}
+
+		return out;
+	}
+
+	static std::string escapeJson(std::string_view text) {
+		std::string escaped{};
+
+		for (char c : text) {
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+
+			// control characters do not appear in paths
+			if ((unsigned char)c >= 0x20)
+				escaped += c;
+		}
+
+		return escaped;
+	}
+
+	bool LoadStats::writeJson(const std::string& path) const {
+		std::ofstream file{ path };
+
+		if (!file.is_open()) {
+			std::cerr << "[LOAD STATS] Can not write " << path << std::endl;
+			return false;
+		}
+
+		const auto items = sorted();
+
+		auto writeItem = [&file](const Item& item, bool named) {
+			file << std::format("{{\"phase\":\"{}\",", phaseName(item.phase));
+
+			if (named)
+				file << std::format("\"name\":\"{}\",", escapeJson(item.name));
+
+			file << std::format("\"count\":{},\"ms\":{:.3f},\"bytes_read\":{},\"bytes_uploaded\":{}}}",
+				item.count, toMs(item.ns), item.bytes_read, item.bytes_uploaded);
+		};
+
+		file << std::format("{{\"startup_ms\":{:.3f},\n\"phases\":[\n", toMs(startup_ns_));
+
+		bool first = true;
+
+		for (const auto& total : phaseTotals(items)) {
+			file << (first ? "" : ",\n");
+			writeItem(total, false);
+			first = false;
+		}
+
+		file << "\n],\n\"items\":[\n";
+
+		for (size_t i = 0; i < items.size(); i++) {
+			file << (i == 0 ? "" : ",\n");
+			writeItem(items[i], true);
+		}
+
+		file << "\n]}\n";
+		return file.good();
+	}
+
+	void LoadStats::finishStartup(const std::string& json_path) {
+		if (finished_.exchange(true))
+			return;
+
+		startup_ns_ = FrameStats::nowNs() - process_start_ns;
+
+		std::cout << "[LOAD STATS] " << report();
+
+		if (!json_path.empty())
+			writeJson(json_path);
+	}
+
+	ScopedLoadTimer::ScopedLoadTimer(LoadPhase phase, std::string_view name)
+		:phase_(phase), name_(name) {
+		begin_ = FrameStats::nowNs();
+	}
+
+	ScopedLoadTimer::~ScopedLoadTimer() {
+		LoadStats::getInstance().record(phase_, name_, FrameStats::nowNs() - begin_, bytes_read_, bytes_uploaded_);
+	}
+}
@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+#include <climits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCKS_SSE 1
+#endif
+
+#include "render/BlockCompression.hpp"
+#include "jobs/ThreadPool.hpp"
+
+namespace dlb {
+	static unsigned short to565(const int color[3]) {
+		return (unsigned short)((((color[0] * 31 + 127) / 255) << 11) | (((color[1] * 63 + 127) / 255) << 5) | ((color[2] * 31 + 127) / 255));
+	}
+
+	static void from565(unsigned short c, int color[3]) {
+		int r = (c >> 11) & 31;
+		int g = (c >> 5) & 63;
+		int b = c & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	/*
+	* Per channel min and max of the 16 texels.
+	*/
+	static void colorBounds(const unsigned char* rgba, unsigned char min[4], unsigned char max[4]) {
+#ifdef BLOCKS_SSE
+		__m128i a = _mm_loadu_si128((const __m128i*)(rgba + 0));
+		__m128i b = _mm_loadu_si128((const __m128i*)(rgba + 16));
+		__m128i c = _mm_loadu_si128((const __m128i*)(rgba + 32));
+		__m128i d = _mm_loadu_si128((const __m128i*)(rgba + 48));
+
+		__m128i lo = _mm_min_epu8(_mm_min_epu8(a, b), _mm_min_epu8(c, d));
+		__m128i hi = _mm_max_epu8(_mm_max_epu8(a, b), _mm_max_epu8(c, d));
+
+		// fold the 4 texels of the register into the first one
+		lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 8));
+		lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+		hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 8));
+		hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+
+		int packed_lo = _mm_cvtsi128_si32(lo);
+		int packed_hi = _mm_cvtsi128_si32(hi);
+		std::memcpy(min, &packed_lo, 4);
+		std::memcpy(max, &packed_hi, 4);
+#else
+		for (int c = 0; c < 4; c++) {
+			min[c] = 255;
+			max[c] = 0;
+		}
+
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) {
+				min[c] = std::min(min[c], rgba[i * 4 + c]);
+				max[c] = std::max(max[c], rgba[i * 4 + c]);
+			}
+		}
+#endif
+	}
+
+	/*
+	* 2 bit index of the closest palette entry for every texel.
+	*/
+	static unsigned int colorIndices(const unsigned char* rgba, const int palette[4][3]) {
+		unsigned int indices = 0;
+
+#ifdef BLOCKS_SSE
+		alignas(16) float r[16], g[16], b[16];
+
+		for (int i = 0; i < 16; i++) {
+			r[i] = rgba[i * 4 + 0];
+			g[i] = rgba[i * 4 + 1];
+			b[i] = rgba[i * 4 + 2];
+		}
+
+		// 4 texels against every palette entry at once
+		for (int i = 0; i < 16; i += 4) {
+			__m128 pr = _mm_load_ps(r + i);
+			__m128 pg = _mm_load_ps(g + i);
+			__m128 pb = _mm_load_ps(b + i);
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i best_index = _mm_setzero_si128();
+
+			for (int k = 0; k < 4; k++) {
+				__m128 dr = _mm_sub_ps(pr, _mm_set1_ps((float)palette[k][0]));
+				__m128 dg = _mm_sub_ps(pg, _mm_set1_ps((float)palette[k][1]));
+				__m128 db = _mm_sub_ps(pb, _mm_set1_ps((float)palette[k][2]));
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(dist, best));
+				best = _mm_min_ps(dist, best);
+				best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, best_index));
+			}
+
+			alignas(16) int lane[4];
+			_mm_store_si128((__m128i*)lane, best_index);
+
+			for (int j = 0; j < 4; j++)
+				indices |= (unsigned int)lane[j] << (2 * (i + j));
+		}
+#else
+		for (int i = 0; i < 16; i++) {
+			int best = INT_MAX;
+			int best_index = 0;
+
+			for (int k = 0; k < 4; k++) {
+				int dr = rgba[i * 4 + 0] - palette[k][0];
+				int dg = rgba[i * 4 + 1] - palette[k][1];
+				int db = rgba[i * 4 + 2] - palette[k][2];
+				int dist = dr * dr + dg * dg + db * db;
+
+				if (dist < best) {
+					best = dist;
+					best_index = k;
+				}
+			}
+
+			indices |= (unsigned int)best_index << (2 * i);
+		}
+#endif
+
+		return indices;
+	}
+
+	void compressBlockBC1(const unsigned char* rgba, unsigned char* out) {
+		unsigned char min[4], max[4];
+		colorBounds(rgba, min, max);
+
+		int e0[3] = { max[0], max[1], max[2] };
+		int e1[3] = { min[0], min[1], min[2] };
+
+		/*
+		* The bounding box diagonal from min to max only fits colours that grow
+		* together, flip red and blue when they run against green.
+		*/
+		int center[3] = { (e0[0] + e1[0]) / 2, (e0[1] + e1[1]) / 2, (e0[2] + e1[2]) / 2 };
+		int cov_rg = 0, cov_bg = 0;
+
+		for (int i = 0; i < 16; i++) {
+			int g = rgba[i * 4 + 1] - center[1];
+			cov_rg += (rgba[i * 4 + 0] - center[0]) * g;
+			cov_bg += (rgba[i * 4 + 2] - center[2]) * g;
+		}
+
+		if (cov_rg < 0)
+			std::swap(e0[0], e1[0]);
+
+		if (cov_bg < 0)
+			std::swap(e0[2], e1[2]);
+
+		// pull the endpoints in a little, the extremes are rarely the best fit
+		for (int c = 0; c < 3; c++) {
+			int inset = (e0[c] - e1[c]) / 16;
+			e0[c] = std::clamp(e0[c] - inset, 0, 255);
+			e1[c] = std::clamp(e1[c] + inset, 0, 255);
+		}
+
+		unsigned short c0 = to565(e0);
+		unsigned short c1 = to565(e1);
+
+		// c0 > c1 selects the 4 colour mode
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		unsigned int indices = 0;
+
+		if (c0 != c1) {
+			int palette[4][3];
+			from565(c0, palette[0]);
+			from565(c1, palette[1]);
+
+			for (int c = 0; c < 3; c++) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			indices = colorIndices(rgba, palette);
+		}
+
+		out[0] = c0 & 0xFF;
+		out[1] = c0 >> 8;
+		out[2] = c1 & 0xFF;
+		out[3] = c1 >> 8;
+		std::memcpy(out + 4, &indices, 4);
+	}
+
+	/*
+	* One channel in the 8 value interpolated mode, the alpha block of BC3
+	* and both halves of BC5.
+	*/
+	static void compressBlockBC4(const unsigned char* rgba, int channel, unsigned char* out) {
+		int lo = 255, hi = 0;
+
+		for (int i = 0; i < 16; i++) {
+			lo = std::min(lo, (int)rgba[i * 4 + channel]);
+			hi = std::max(hi, (int)rgba[i * 4 + channel]);
+		}
+
+		out[0] = hi;
+		out[1] = lo;
+
+		u64 bits = 0;
+
+		if (hi > lo) {
+			for (int i = 0; i < 16; i++) {
+				// position between hi (0) and lo (7) in sevenths
+				int t = ((hi - rgba[i * 4 + channel]) * 7 + (hi - lo) / 2) / (hi - lo);
+				u64 index = t == 0 ? 0 : t == 7 ? 1 : t + 1;
+				bits |= index << (3 * i);
+			}
+		}
+
+		for (int k = 0; k < 6; k++)
+			out[2 + k] = (bits >> (8 * k)) & 0xFF;
+	}
+
+	void compressBlockBC3(const unsigned char* rgba, unsigned char* out) {
+		compressBlockBC4(rgba, 3, out);
+		compressBlockBC1(rgba, out + 8);
+	}
+
+	void compressBlockBC5(const unsigned char* rgba, unsigned char* out) {
+		compressBlockBC4(rgba, 0, out);
+		compressBlockBC4(rgba, 1, out + 8);
+	}
+
+	BlockFormat chooseBlockFormat(const unsigned char* rgba, int width, int height) {
+		const size_t texels = (size_t)width * height;
+
+		for (size_t i = 0; i < texels; i++) {
+			if (rgba[i * 4 + 3] != 255)
+				return BlockFormat::BC3;
+		}
+
+		return BlockFormat::BC1;
+	}
+
+	/*
+	* Next mip level, 2x2 box filter, the last row/column is repeated for odd sizes.
+	*/
+	static std::vector<unsigned char> downsample(const std::vector<unsigned char>& src, int width, int height) {
+		const int w = std::max(1, width / 2);
+		const int h = std::max(1, height / 2);
+
+		std::vector<unsigned char> dst((size_t)w * h * 4);
+
+		for (int y = 0; y < h; y++) {
+			int y0 = std::min(2 * y, height - 1);
+			int y1 = std::min(2 * y + 1, height - 1);
+
+			for (int x = 0; x < w; x++) {
+				int x0 = std::min(2 * x, width - 1);
+				int x1 = std::min(2 * x + 1, width - 1);
+
+				for (int c = 0; c < 4; c++) {
+					int sum = src[((size_t)y0 * width + x0) * 4 + c] + src[((size_t)y0 * width + x1) * 4 + c]
+						+ src[((size_t)y1 * width + x0) * 4 + c] + src[((size_t)y1 * width + x1) * 4 + c];
+
+					dst[((size_t)y * w + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+
+		return dst;
+	}
+
+	static void compressLevel(const unsigned char* rgba, int width, int height, BlockFormat format, unsigned char* out) {
+		const int blocks_x = (width + 3) / 4;
+		const int blocks_y = (height + 3) / 4;
+		const uint block_bytes = blockBytes(format);
+
+		// a few hundred blocks per job
+		const uint grain = std::max(1, 256 / blocks_x);
+
+		ThreadPool::getInstance().parallelFor(blocks_y, grain, [&](uint begin, uint end) {
+			unsigned char block[64];
+
+			for (uint by = begin; by < end; by++) {
+				for (int bx = 0; bx < blocks_x; bx++) {
+					// the edge texels are repeated in partial blocks
+					for (int y = 0; y < 4; y++) {
+						int sy = std::min((int)by * 4 + y, height - 1);
+
+						for (int x = 0; x < 4; x++) {
+							int sx = std::min(bx * 4 + x, width - 1);
+							std::memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+						}
+					}
+
+					unsigned char* dst = out + ((size_t)by * blocks_x + bx) * block_bytes;
+
+					switch (format) {
+					case BlockFormat::BC1: compressBlockBC1(block, dst); break;
+					case BlockFormat::BC3: compressBlockBC3(block, dst); break;
+					case BlockFormat::BC5: compressBlockBC5(block, dst); break;
+					}
+				}
+			}
+		});
+	}
+
+	CompressedImage compressImage(const unsigned char* rgba, int width, int height, BlockFormat format) {
+		CompressedImage image{};
+		image.format = format;
+		image.width = width;
+		image.height = height;
+
+		struct Level {
+			std::vector<unsigned char> pixels;
+			int width, height;
+			size_t offset;
+		};
+
+		std::vector<Level> levels{};
+		levels.push_back({ std::vector<unsigned char>(rgba, rgba + (size_t)width * height * 4), width, height, 0 });
+
+		while (levels.back().width > 1 || levels.back().height > 1) {
+			const auto& last = levels.back();
+			levels.push_back({ downsample(last.pixels, last.width, last.height), std::max(1, last.width / 2), std::max(1, last.height / 2), 0 });
+		}
+
+		size_t total = 0;
+
+		for (auto& level : levels) {
+			level.offset = total;
+			total += compressedLevelBytes(format, level.width, level.height);
+		}
+
+		image.storage.resize(total);
+
+		for (const auto& level : levels) {
+			compressLevel(level.pixels.data(), level.width, level.height, format, image.storage.data() + level.offset);
+			image.levels.push_back(std::span<const unsigned char>(image.storage.data() + level.offset, compressedLevelBytes(format, level.width, level.height)));
+		}
+
+		return image;
+	}
+}
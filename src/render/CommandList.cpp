@@ -0,0 +1,51 @@
+#include <algorithm>
+
+#include "render/CommandList.hpp"
+#include "jobs/ThreadPool.hpp"
+#include "profiling/CpuProfiler.hpp"
+
+namespace dlb {
+	void CommandBuffer::build(uint count, const BuildFn& fn) {
+		PROFILE_ZONE("CommandBuffer::build");
+
+		auto& pool = ThreadPool::getInstance();
+
+		// parallelFor never runs more than workerCount() + 1 chunks
+		while (lists_.size() < pool.workerCount() + 1)
+			lists_.push_back(std::make_unique<CommandList>());
+
+		for (auto& list : lists_)
+			list->reset();
+
+		std::atomic<uint> next_list{ 0 };
+
+		pool.parallelFor(count, GRAIN, [&](uint begin, uint end) {
+			PROFILE_ZONE("CommandList::record");
+			fn(*lists_[next_list.fetch_add(1, std::memory_order_relaxed)], begin, end);
+		});
+
+		{
+			PROFILE_ZONE("CommandBuffer::sort");
+
+			sorted_.clear();
+
+			for (const auto& list : lists_)
+				sorted_.insert(sorted_.end(), list->getKeys().begin(), list->getKeys().end());
+
+			std::sort(sorted_.begin(), sorted_.end(), [](const RenderCommandKey& a, const RenderCommandKey& b) {
+				return a.key < b.key;
+			});
+		}
+	}
+
+	std::span<const RenderCommandKey> CommandBuffer::getPass(RenderPass pass) const {
+		auto pass_of = [](const RenderCommandKey& k) { return (RenderPass)(k.key >> 62); };
+
+		auto begin = std::partition_point(sorted_.begin(), sorted_.end(),
+			[&](const RenderCommandKey& k) { return pass_of(k) < pass; });
+		auto end = std::partition_point(begin, sorted_.end(),
+			[&](const RenderCommandKey& k) { return pass_of(k) == pass; });
+
+		return { begin, end };
+	}
+}
@@ -0,0 +1,122 @@
+#include <glad/glad.h>
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+
+#include "render/DebugDraw.hpp"
+#include "profiling/CpuProfiler.hpp"
+
+namespace dlb {
+	static unsigned int packColor(const glm::vec4& color) {
+		glm::uvec4 c = glm::uvec4(glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f);
+		return c.r | (c.g << 8) | (c.b << 16) | (c.a << 24);
+	}
+
+	void DebugDraw::line(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color) {
+		unsigned int c = packColor(color);
+		vertices_.push_back({ a, c });
+		vertices_.push_back({ b, c });
+	}
+
+	/*
+	* Corners are indexed by bits: x = 1, y = 2, z = 4.
+	*/
+	void DebugDraw::boxCorners(const glm::vec3 corners[8], unsigned int color) {
+		static const int EDGES[12][2] = {
+			{0, 1}, {2, 3}, {4, 5}, {6, 7},
+			{0, 2}, {1, 3}, {4, 6}, {5, 7},
+			{0, 4}, {1, 5}, {2, 6}, {3, 7},
+		};
+
+		for (const auto& edge : EDGES) {
+			vertices_.push_back({ corners[edge[0]], color });
+			vertices_.push_back({ corners[edge[1]], color });
+		}
+	}
+
+	void DebugDraw::box(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color) {
+		glm::vec3 corners[8];
+
+		for (int i = 0; i < 8; i++)
+			corners[i] = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+
+		boxCorners(corners, packColor(color));
+	}
+
+	void DebugDraw::box(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform, const glm::vec4& color) {
+		glm::vec3 corners[8];
+
+		for (int i = 0; i < 8; i++)
+			corners[i] = glm::vec3(transform * glm::vec4(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f));
+
+		boxCorners(corners, packColor(color));
+	}
+
+	void DebugDraw::sphere(const glm::vec3& center, float radius, const glm::vec4& color) {
+		unsigned int c = packColor(color);
+
+		for (uint i = 0; i < SPHERE_SEGMENTS; i++) {
+			float a0 = glm::two_pi<float>() * i / SPHERE_SEGMENTS;
+			float a1 = glm::two_pi<float>() * (i + 1) / SPHERE_SEGMENTS;
+			glm::vec2 p0 = glm::vec2(std::cos(a0), std::sin(a0)) * radius;
+			glm::vec2 p1 = glm::vec2(std::cos(a1), std::sin(a1)) * radius;
+
+			vertices_.push_back({ center + glm::vec3(p0.x, p0.y, 0.0f), c });
+			vertices_.push_back({ center + glm::vec3(p1.x, p1.y, 0.0f), c });
+			vertices_.push_back({ center + glm::vec3(p0.x, 0.0f, p0.y), c });
+			vertices_.push_back({ center + glm::vec3(p1.x, 0.0f, p1.y), c });
+			vertices_.push_back({ center + glm::vec3(0.0f, p0.x, p0.y), c });
+			vertices_.push_back({ center + glm::vec3(0.0f, p1.x, p1.y), c });
+		}
+	}
+
+	void DebugDraw::frustum(const glm::mat4& view_projection, const glm::vec4& color) {
+		glm::mat4 inverse = glm::inverse(view_projection);
+		glm::vec3 corners[8];
+
+		for (int i = 0; i < 8; i++) {
+			glm::vec4 p = inverse * glm::vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+			corners[i] = glm::vec3(p) / p.w;
+		}
+
+		boxCorners(corners, packColor(color));
+	}
+
+	DebugRenderer::~DebugRenderer() {
+		glDeleteVertexArrays(1, &vao_);
+		glDeleteBuffers(1, &vbo_);
+	}
+
+	void DebugRenderer::flush(const DebugDraw& draw, const ShaderProgram& sp, const glm::mat4& view_projection) {
+		PROFILE_ZONE("DebugRenderer::flush");
+
+		const auto& vertices = draw.getVertices();
+
+		if (vertices.empty())
+			return;
+
+		if (!vao_) {
+			glGenVertexArrays(1, &vao_);
+			glGenBuffers(1, &vbo_);
+
+			glBindVertexArray(vao_);
+			glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+
+			setupVertexAttributes<DebugVertex>();
+		}
+
+		glBindVertexArray(vao_);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+
+		// orphan the previous frame's storage, the driver does not wait for it
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(DebugVertex), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(DebugVertex), vertices.data());
+
+		sp.use();
+		sp.setUniform("u_view_projection", view_projection);
+
+		glDrawArrays(GL_LINES, 0, vertices.size());
+
+		glBindVertexArray(0);
+	}
+}
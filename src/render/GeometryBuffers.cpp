@@ -0,0 +1,40 @@
+#include <utility>
+
+#include "render/GeometryBuffers.hpp"
+
+namespace dlb {
+	GeometryBuffers::~GeometryBuffers() {
+		destroy();
+	}
+
+	GeometryBuffers::GeometryBuffers(GeometryBuffers&& x) noexcept {
+		*this = std::move(x);
+	}
+
+	GeometryBuffers& GeometryBuffers::operator=(GeometryBuffers&& x) noexcept {
+		std::swap(vao_, x.vao_);
+		std::swap(vbo_, x.vbo_);
+		std::swap(ebo_, x.ebo_);
+		return *this;
+	}
+
+	void GeometryBuffers::create() {
+		if (vao_)
+			return;
+
+		glGenVertexArrays(1, &vao_);
+		glGenBuffers(1, &vbo_);
+		glGenBuffers(1, &ebo_);
+	}
+
+	void GeometryBuffers::destroy() {
+		if (!vao_)
+			return;
+
+		glDeleteVertexArrays(1, &vao_);
+		glDeleteBuffers(1, &vbo_);
+		glDeleteBuffers(1, &ebo_);
+
+		vao_ = vbo_ = ebo_ = 0;
+	}
+}
@@ -0,0 +1,115 @@
+#include <glad/glad.h>
+
+#include <cstring>
+#include <utility>
+
+#include "render/MaterialTable.hpp"
+
+namespace dlb {
+	MaterialTable::~MaterialTable() {
+		if (ubo_)
+			glDeleteBuffers(1, &ubo_);
+	}
+
+	MaterialTable::MaterialTable(MaterialTable&& x) noexcept
+		:constants_(std::move(x.constants_)),
+		materials_(std::move(x.materials_)),
+		textures_(std::move(x.textures_)),
+		ubo_(x.ubo_),
+		stride_(x.stride_) {
+
+		x.ubo_ = 0;
+	}
+
+	MaterialTable& MaterialTable::operator=(MaterialTable&& x) noexcept {
+		std::swap(constants_, x.constants_);
+		std::swap(materials_, x.materials_);
+		std::swap(textures_, x.textures_);
+		std::swap(ubo_, x.ubo_);
+		std::swap(stride_, x.stride_);
+		return *this;
+	}
+
+	uint MaterialTable::add(const MaterialConstants& constants, std::span<const MaterialTexture> textures) {
+		// meshes of a model often share their material
+		for (uint i = 0; i < materials_.size(); i++) {
+			const auto& entry = materials_[i];
+
+			if (entry.texture_count != textures.size() || std::memcmp(&constants_[i], &constants, sizeof(MaterialConstants)) != 0)
+				continue;
+
+			bool same = true;
+
+			for (uint t = 0; t < textures.size() && same; t++)
+				same = textures_[entry.first_texture + t].unit == textures[t].unit && textures_[entry.first_texture + t].id == textures[t].id;
+
+			if (same)
+				return i;
+		}
+
+		constants_.push_back(constants);
+		materials_.push_back({ (uint)textures_.size(), (uint)textures.size() });
+		textures_.insert(textures_.end(), textures.begin(), textures.end());
+
+		return materials_.size() - 1;
+	}
+
+	void MaterialTable::upload() {
+		if (constants_.empty())
+			return;
+
+		// every material starts at a legal glBindBufferRange offset
+		GLint alignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		stride_ = (sizeof(MaterialConstants) + alignment - 1) / alignment * alignment;
+
+		std::vector<unsigned char> data(stride_ * constants_.size());
+
+		for (uint i = 0; i < constants_.size(); i++)
+			std::memcpy(data.data() + i * stride_, &constants_[i], sizeof(MaterialConstants));
+
+		glGenBuffers(1, &ubo_);
+		glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+		glBufferData(GL_UNIFORM_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		// the GPU copy is the only one needed from now on
+		constants_.clear();
+		constants_.shrink_to_fit();
+	}
+
+	void MaterialTable::bind(uint material) const {
+		const auto& entry = materials_[material];
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, BLOCK_BINDING, ubo_, material * stride_, sizeof(MaterialConstants));
+
+		for (uint i = 0; i < entry.texture_count; i++) {
+			const auto& texture = textures_[entry.first_texture + i];
+			glActiveTexture(GL_TEXTURE0 + texture.unit);
+			glBindTexture(GL_TEXTURE_2D, texture.id);
+		}
+
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	void MaterialTable::bindProgram(const ShaderProgram& sp) {
+		if (!sp.isReady())
+			return;
+
+		static const int diffuse_units[MAX_TEXTURES] = { DIFFUSE_UNIT, DIFFUSE_UNIT + 1, DIFFUSE_UNIT + 2, DIFFUSE_UNIT + 3 };
+		static const int specular_units[MAX_TEXTURES] = { SPECULAR_UNIT, SPECULAR_UNIT + 1, SPECULAR_UNIT + 2, SPECULAR_UNIT + 3 };
+		static const int array_units[MAX_TEXTURES] = { ARRAY_UNIT, ARRAY_UNIT + 1, ARRAY_UNIT + 2, ARRAY_UNIT + 3 };
+
+		GLuint program = sp.getProgramId();
+		GLuint block = glGetUniformBlockIndex(program, "MaterialBlock");
+
+		if (block != GL_INVALID_INDEX)
+			glUniformBlockBinding(program, block, BLOCK_BINDING);
+
+		// samplers the permutation does not use are simply not found
+		sp.use();
+		sp.setUniform("u_diffuse_textures", diffuse_units, MAX_TEXTURES);
+		sp.setUniform("u_specular_textures", specular_units, MAX_TEXTURES);
+		sp.setUniform("u_texture_arrays", array_units, MAX_TEXTURES);
+	}
+}
@@ -0,0 +1,129 @@
+#include <cstring>
+
+#include "render/RenderThread.hpp"
+#include "profiling/CpuProfiler.hpp"
+
+namespace dlb {
+	void UiDrawData::capture(const ImDrawData* src) {
+		if (!src || !src->Valid) {
+			data_.Valid = false;
+			return;
+		}
+
+		while (lists_.size() < (size_t)src->CmdListsCount)
+			lists_.push_back(std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData()));
+
+		list_ptrs_.resize(src->CmdListsCount);
+
+		// resize + memcpy instead of ImVector::operator=, which frees first
+		auto copy = [](auto& dst, const auto& from) {
+			dst.resize(from.Size);
+			if (from.Size)
+				std::memcpy(dst.Data, from.Data, from.size_in_bytes());
+		};
+
+		for (int i = 0; i < src->CmdListsCount; i++) {
+			const ImDrawList* from = src->CmdLists[i];
+			ImDrawList* to = lists_[i].get();
+
+			copy(to->CmdBuffer, from->CmdBuffer);
+			copy(to->IdxBuffer, from->IdxBuffer);
+			copy(to->VtxBuffer, from->VtxBuffer);
+			to->Flags = from->Flags;
+
+			list_ptrs_[i] = to;
+		}
+
+		data_ = *src;
+		data_.CmdLists = list_ptrs_.data();
+	}
+
+	RenderThread::~RenderThread() {
+		stop();
+	}
+
+	void RenderThread::start(RenderFn render, ContextFn make_current, bool threaded) {
+		render_ = std::move(render);
+		make_current_ = std::move(make_current);
+		stopping_ = false;
+
+		if (!threaded)
+			return;
+
+		make_current_(false);
+		thread_ = std::thread{ [this] { loop(); } };
+	}
+
+	RenderSnapshot& RenderThread::acquire() {
+		PROFILE_ZONE("RenderThread::acquire");
+
+		std::unique_lock lock{ mutex_ };
+
+		// slot published_ % SLOTS is free once frame published_ - SLOTS is drawn
+		cv_.wait(lock, [this] { return published_ - rendered_ < SLOTS; });
+
+		auto& snapshot = slots_[published_ % SLOTS];
+		snapshot.frame = published_;
+		return snapshot;
+	}
+
+	void RenderThread::publish() {
+		if (!isThreaded()) {
+			render_(slots_[published_ % SLOTS]);
+			published_++;
+			rendered_++;
+			return;
+		}
+
+		{
+			std::lock_guard lock{ mutex_ };
+			published_++;
+		}
+
+		cv_.notify_all();
+	}
+
+	void RenderThread::loop() {
+		make_current_(true);
+
+		for (;;) {
+			RenderSnapshot* snapshot;
+
+			{
+				std::unique_lock lock{ mutex_ };
+				cv_.wait(lock, [this] { return published_ > rendered_ || stopping_; });
+
+				if (published_ == rendered_)
+					break;
+
+				snapshot = &slots_[rendered_ % SLOTS];
+			}
+
+			render_(*snapshot);
+
+			{
+				std::lock_guard lock{ mutex_ };
+				rendered_++;
+			}
+
+			cv_.notify_all();
+		}
+
+		make_current_(false);
+	}
+
+	void RenderThread::stop() {
+		if (!isThreaded())
+			return;
+
+		{
+			std::lock_guard lock{ mutex_ };
+			stopping_ = true;
+		}
+
+		cv_.notify_all();
+		thread_.join();
+
+		make_current_(true);
+	}
+}
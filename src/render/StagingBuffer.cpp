@@ -0,0 +1,37 @@
+#include <cstring>
+
+#include "render/StagingBuffer.hpp"
+
+namespace dlb {
+	StagingBuffer::~StagingBuffer() {
+		if (pbo_)
+			glDeleteBuffers(1, &pbo_);
+	}
+
+	const void* StagingBuffer::stage(const void* data, size_t bytes) {
+		if (!pbo_)
+			glGenBuffers(1, &pbo_);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+
+		// orphan, the transfer still reading the previous storage keeps it
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+		if (!mapped) {
+			unbind();
+			return data;
+		}
+
+		std::memcpy(mapped, data, bytes);
+
+		if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+			unbind();
+			return data;
+		}
+
+		// offset 0 into the bound unpack buffer
+		return nullptr;
+	}
+}
@@ -0,0 +1,267 @@
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+
+#include <stb_image/stb_image.h>
+
+#include "render/TextureCache.hpp"
+#include "io/VirtualFileSystem.hpp"
+#include "profiling/LoadStats.hpp"
+
+namespace dlb {
+	// VkFormat values of the BlockFormats
+	static constexpr uint VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+	static constexpr uint VK_FORMAT_BC3_UNORM_BLOCK = 137;
+	static constexpr uint VK_FORMAT_BC5_UNORM_BLOCK = 141;
+
+	static uint vkFormat(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		case BlockFormat::BC3: return VK_FORMAT_BC3_UNORM_BLOCK;
+		case BlockFormat::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+		}
+
+		return 0;
+	}
+
+	static bool blockFormat(uint vk_format, BlockFormat& format) {
+		switch (vk_format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK: format = BlockFormat::BC1; return true;
+		case VK_FORMAT_BC3_UNORM_BLOCK: format = BlockFormat::BC3; return true;
+		case VK_FORMAT_BC5_UNORM_BLOCK: format = BlockFormat::BC5; return true;
+		}
+
+		return false;
+	}
+
+	/*
+	* Basic data format descriptor (Khronos Data Format 1.3) of `format`,
+	* mandatory in every KTX2 file.
+	*/
+	static std::vector<uint> describeFormat(BlockFormat format) {
+		struct Sample {
+			uint channel;
+			uint bit_offset;
+		};
+
+		// KHR_DF_MODEL_BC1A / BC3 / BC5 and their channel ids
+		uint model = 0;
+		std::vector<Sample> samples{};
+
+		switch (format) {
+		case BlockFormat::BC1:
+			model = 128;
+			samples = { { 0, 0 } };
+			break;
+
+		case BlockFormat::BC3:
+			model = 130;
+			samples = { { 15, 0 }, { 0, 64 } };
+			break;
+
+		case BlockFormat::BC5:
+			model = 132;
+			samples = { { 0, 0 }, { 1, 64 } };
+			break;
+		}
+
+		const uint block_size = 24 + 16 * (uint)samples.size();
+
+		std::vector<uint> dfd{};
+		dfd.push_back(4 + block_size);
+		// Khronos vendor, basic descriptor
+		dfd.push_back(0);
+		dfd.push_back(2 | (block_size << 16));
+		// BT.709 primaries, linear transfer
+		dfd.push_back(model | (1 << 8) | (1 << 16));
+		// 4x4 texel blocks
+		dfd.push_back(3 | (3 << 8));
+		dfd.push_back(blockBytes(format));
+		dfd.push_back(0);
+
+		// 64 bits per sample
+		for (const auto& sample : samples) {
+			dfd.push_back(sample.bit_offset | (63 << 16) | (sample.channel << 24));
+			dfd.push_back(0);
+			dfd.push_back(0);
+			dfd.push_back(0xFFFFFFFF);
+		}
+
+		return dfd;
+	}
+
+	std::string cookedTexturePath(const std::string& path) {
+		return path + TEXTURE_CACHE_EXTENSION;
+	}
+
+	bool writeKtx2File(const std::string& path, const CompressedImage& image) {
+		const std::vector<uint> dfd = describeFormat(image.format);
+		const u64 alignment = blockBytes(image.format);
+		const uint level_count = image.levels.size();
+
+		Ktx2Header header{};
+		std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(header.identifier));
+		header.vk_format = vkFormat(image.format);
+		header.type_size = 1;
+		header.pixel_width = image.width;
+		header.pixel_height = image.height;
+		header.face_count = 1;
+		header.level_count = level_count;
+		header.dfd_byte_offset = sizeof(Ktx2Header) + level_count * sizeof(Ktx2Level);
+		header.dfd_byte_length = dfd.size() * sizeof(uint);
+
+		// the smallest level is stored first
+		std::vector<Ktx2Level> levels(level_count);
+		u64 offset = header.dfd_byte_offset + header.dfd_byte_length;
+
+		for (int i = level_count - 1; i >= 0; i--) {
+			offset = (offset + alignment - 1) / alignment * alignment;
+			levels[i] = { offset, image.levels[i].size(), image.levels[i].size() };
+			offset += image.levels[i].size();
+		}
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+
+		if (!file.is_open()) {
+			std::cerr << "[TEXTURECACHE] Could not open " << path << " for writing" << std::endl;
+			return false;
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)levels.data(), levels.size() * sizeof(Ktx2Level));
+		file.write((const char*)dfd.data(), dfd.size() * sizeof(uint));
+
+		static const char padding[16] = {};
+		u64 written = header.dfd_byte_offset + header.dfd_byte_length;
+
+		for (int i = level_count - 1; i >= 0; i--) {
+			file.write(padding, levels[i].byte_offset - written);
+			file.write((const char*)image.levels[i].data(), image.levels[i].size());
+			written = levels[i].byte_offset + levels[i].byte_length;
+		}
+
+		if (!file.good()) {
+			std::cerr << "[TEXTURECACHE] Could not write " << path << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool readKtx2File(FileView&& file, CompressedImage& image) {
+		if (file.size() < sizeof(Ktx2Header))
+			return false;
+
+		Ktx2Header header{};
+		std::memcpy(&header, file.data(), sizeof(header));
+
+		if (std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+			std::cerr << "[TEXTURECACHE] Not a KTX2 file" << std::endl;
+			return false;
+		}
+
+		BlockFormat format{};
+
+		if (!blockFormat(header.vk_format, format) || header.supercompression_scheme != 0 ||
+			header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1 ||
+			header.pixel_width == 0 || header.pixel_height == 0) {
+			std::cerr << "[TEXTURECACHE] Unsupported KTX2 file, format " << header.vk_format << std::endl;
+			return false;
+		}
+
+		// 0 asks for runtime mip generation, the cache always stores the whole chain
+		if (header.level_count == 0 || header.level_count > 32 ||
+			sizeof(Ktx2Header) + (u64)header.level_count * sizeof(Ktx2Level) > file.size())
+			return false;
+
+		image.format = format;
+		image.width = header.pixel_width;
+		image.height = header.pixel_height;
+		image.levels.clear();
+
+		for (uint i = 0; i < header.level_count; i++) {
+			Ktx2Level level{};
+			std::memcpy(&level, file.data() + sizeof(Ktx2Header) + i * sizeof(Ktx2Level), sizeof(level));
+
+			const size_t expected = compressedLevelBytes(format, std::max(1, image.width >> i), std::max(1, image.height >> i));
+
+			if (level.byte_length < expected || level.byte_offset > file.size() || expected > file.size() - level.byte_offset) {
+				std::cerr << "[TEXTURECACHE] KTX2 file is truncated or corrupt" << std::endl;
+				image.levels.clear();
+				return false;
+			}
+
+			image.levels.push_back(std::span<const unsigned char>(file.data() + level.byte_offset, expected));
+		}
+
+		image.file = std::move(file);
+		return true;
+	}
+
+	/*
+	* A cache older than its source is ignored and written again, a packed
+	* cache is always up to date.
+	*/
+	static bool isCacheUpToDate(const std::string& source, const std::string& cached) {
+		auto& vfs = VirtualFileSystem::getInstance();
+
+		if (vfs.isPacked(cached))
+			return true;
+
+		std::error_code error{};
+		const std::string cached_file = vfs.resolve(cached);
+
+		if (!std::filesystem::exists(cached_file, error))
+			return false;
+
+		const std::string source_file = vfs.resolve(source);
+
+		// shipped without the loose source
+		if (!std::filesystem::exists(source_file, error))
+			return true;
+
+		return std::filesystem::last_write_time(cached_file, error) >= std::filesystem::last_write_time(source_file, error);
+	}
+
+	bool loadCompressedTexture(const std::string& path, bool normal_map, CompressedImage& image) {
+		auto& vfs = VirtualFileSystem::getInstance();
+		const std::string cached = cookedTexturePath(path);
+
+		ScopedLoadTimer timer{ LoadPhase::TextureDecode, path };
+
+		if (isCacheUpToDate(path, cached)) {
+			FileView file = FileReader::open(cached);
+			timer.addBytesRead(file.size());
+
+			if (file && readKtx2File(std::move(file), image))
+				return true;
+
+			std::cerr << "[TEXTURECACHE] Could not read " << cached << ", compressing " << path << std::endl;
+		}
+
+		int width = 0, height = 0, channels = 0;
+		unsigned char* pixels = nullptr;
+		const FileView source = FileReader::open(path);
+		timer.addBytesRead(source.size());
+
+		if (source)
+			pixels = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, STBI_rgb_alpha);
+
+		if (!pixels) {
+			std::cout << "Failed to load texture: " << path << std::endl;
+			return false;
+		}
+
+		const BlockFormat format = normal_map ? BlockFormat::BC5 : chooseBlockFormat(pixels, width, height);
+
+		image = compressImage(pixels, width, height, format);
+		stbi_image_free(pixels);
+
+		// a failed write only costs the compression again on the next start
+		writeKtx2File(vfs.resolve(cached), image);
+
+		return true;
+	}
+}
@@ -0,0 +1,243 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CLUSTERS_SSE 1
+#endif
+
+#include "scene/ClusteredLighting.hpp"
+#include "jobs/ThreadPool.hpp"
+#include "profiling/CpuProfiler.hpp"
+
+namespace scene {
+	ClusteredLighting::~ClusteredLighting() {
+		glDeleteTextures(1, &lights_texture_);
+		glDeleteTextures(1, &grid_texture_);
+		glDeleteTextures(1, &indices_texture_);
+		glDeleteBuffers(1, &lights_buffer_);
+		glDeleteBuffers(1, &grid_buffer_);
+		glDeleteBuffers(1, &indices_buffer_);
+	}
+
+	void ClusteredLighting::createBuffers() {
+		glGenBuffers(1, &lights_buffer_);
+		glGenBuffers(1, &grid_buffer_);
+		glGenBuffers(1, &indices_buffer_);
+
+		glGenTextures(1, &lights_texture_);
+		glGenTextures(1, &grid_texture_);
+		glGenTextures(1, &indices_texture_);
+
+		scratch_.resize(CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER);
+		scratch_counts_.resize(CLUSTER_COUNT);
+		grid_.resize(CLUSTER_COUNT * 2);
+	}
+
+	/*
+	* View-space AABB of every cluster. The camera looks down -Z, depth slices
+	* are exponential so clusters keep a similar shape at every distance.
+	*/
+	void ClusteredLighting::buildClusterBounds(float fov, float aspect, float z_near, float z_far) {
+		bounds_.resize(CLUSTER_COUNT);
+
+		const float tan_y = std::tan(glm::radians(fov) * 0.5f);
+		const float tan_x = tan_y * aspect;
+
+		for (uint z = 0; z < CLUSTERS_Z; z++) {
+			float d0 = z_near * std::pow(z_far / z_near, (float)z / CLUSTERS_Z);
+			float d1 = z_near * std::pow(z_far / z_near, (float)(z + 1) / CLUSTERS_Z);
+
+			for (uint y = 0; y < CLUSTERS_Y; y++) {
+				float ny0 = -1.0f + 2.0f * y / CLUSTERS_Y;
+				float ny1 = -1.0f + 2.0f * (y + 1) / CLUSTERS_Y;
+
+				for (uint x = 0; x < CLUSTERS_X; x++) {
+					float nx0 = -1.0f + 2.0f * x / CLUSTERS_X;
+					float nx1 = -1.0f + 2.0f * (x + 1) / CLUSTERS_X;
+
+					glm::vec3 min{ std::numeric_limits<float>::infinity() };
+					glm::vec3 max{ -std::numeric_limits<float>::infinity() };
+
+					for (float d : { d0, d1 }) {
+						for (float nx : { nx0, nx1 }) {
+							for (float ny : { ny0, ny1 }) {
+								glm::vec3 p{ nx * d * tan_x, ny * d * tan_y, -d };
+								min = glm::min(min, p);
+								max = glm::max(max, p);
+							}
+						}
+					}
+
+					bounds_[x + CLUSTERS_X * (y + CLUSTERS_Y * z)] = { min, max };
+				}
+			}
+		}
+	}
+
+	/*
+	* Sphere versus AABB test of every light against the clusters in [begin, end),
+	* 4 lights per iteration.
+	*/
+	void ClusteredLighting::cullRange(uint begin, uint end) {
+		PROFILE_ZONE("ClusteredLighting::cullRange");
+
+		const uint padded = xs_.size();
+
+		for (uint c = begin; c < end; c++) {
+			const auto& b = bounds_[c];
+			uint* out = &scratch_[c * MAX_LIGHTS_PER_CLUSTER];
+			uint count = 0;
+
+#ifdef CLUSTERS_SSE
+			const __m128 min_x = _mm_set1_ps(b.min.x), max_x = _mm_set1_ps(b.max.x);
+			const __m128 min_y = _mm_set1_ps(b.min.y), max_y = _mm_set1_ps(b.max.y);
+			const __m128 min_z = _mm_set1_ps(b.min.z), max_z = _mm_set1_ps(b.max.z);
+			const __m128 zero = _mm_setzero_ps();
+
+			for (uint i = 0; i < padded; i += 4) {
+				__m128 px = _mm_loadu_ps(&xs_[i]);
+				__m128 py = _mm_loadu_ps(&ys_[i]);
+				__m128 pz = _mm_loadu_ps(&zs_[i]);
+				__m128 r = _mm_loadu_ps(&radii_[i]);
+
+				// distance from the sphere center to the box, per axis
+				__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_x, px), _mm_sub_ps(px, max_x)), zero);
+				__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_y, py), _mm_sub_ps(py, max_y)), zero);
+				__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_z, pz), _mm_sub_ps(pz, max_z)), zero);
+
+				__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_mul_ps(r, r)));
+
+				while (mask && count < MAX_LIGHTS_PER_CLUSTER) {
+					int lane = 0;
+					while (!(mask & (1 << lane)))
+						lane++;
+
+					out[count++] = i + lane;
+					mask &= mask - 1;
+				}
+			}
+#else
+			for (uint i = 0; i < padded && count < MAX_LIGHTS_PER_CLUSTER; i++) {
+				float dx = std::max({ b.min.x - xs_[i], xs_[i] - b.max.x, 0.0f });
+				float dy = std::max({ b.min.y - ys_[i], ys_[i] - b.max.y, 0.0f });
+				float dz = std::max({ b.min.z - zs_[i], zs_[i] - b.max.z, 0.0f });
+
+				if (dx * dx + dy * dy + dz * dz <= radii_[i] * radii_[i])
+					out[count++] = i;
+			}
+#endif
+			scratch_counts_[c] = count;
+		}
+	}
+
+	void ClusteredLighting::update(const std::vector<dlb::LocalLight>& lights, const glm::mat4& view,
+		float fov, float aspect, float z_near, float z_far) {
+		PROFILE_ZONE("ClusteredLighting::update");
+
+		if (lights_buffer_ == 0)
+			createBuffers();
+
+		glm::vec4 frustum{ fov, aspect, z_near, z_far };
+
+		if (frustum != frustum_) {
+			buildClusterBounds(fov, aspect, z_near, z_far);
+			frustum_ = frustum;
+		}
+
+		const uint light_count = lights.size();
+		light_count_ = light_count;
+
+		/*
+		* Lights to view space. Spot lights are culled with the sphere
+		* around their cone, padding lanes can never intersect a cluster.
+		*/
+		const uint padded = (light_count + 3) & ~3u;
+		xs_.assign(padded, 1e30f);
+		ys_.assign(padded, 1e30f);
+		zs_.assign(padded, 1e30f);
+		radii_.assign(padded, 0.0f);
+
+		for (uint i = 0; i < light_count; i++) {
+			glm::vec4 p = view * glm::vec4(lights[i].position, 1.0f);
+			xs_[i] = p.x;
+			ys_[i] = p.y;
+			zs_[i] = p.z;
+			radii_[i] = lights[i].radius;
+		}
+
+		auto& pool = dlb::ThreadPool::getInstance();
+		pool.parallelFor(CLUSTER_COUNT, CLUSTERS_X * CLUSTERS_Y, [this](uint begin, uint end) {
+			cullRange(begin, end);
+		});
+
+		/*
+		* Compact the per-cluster lists into one index list.
+		*/
+		indices_.clear();
+		uint max_cluster_lights = 0;
+
+		for (uint c = 0; c < CLUSTER_COUNT; c++) {
+			uint count = scratch_counts_[c];
+			grid_[c * 2 + 0] = indices_.size();
+			grid_[c * 2 + 1] = count;
+			indices_.insert(indices_.end(), &scratch_[c * MAX_LIGHTS_PER_CLUSTER], &scratch_[c * MAX_LIGHTS_PER_CLUSTER] + count);
+			max_cluster_lights = std::max(max_cluster_lights, count);
+		}
+
+		max_cluster_lights_ = max_cluster_lights;
+
+		// buffer textures can not be empty
+		if (indices_.empty())
+			indices_.push_back(0);
+
+		/*
+		* Upload, orphaning the previous storage every frame.
+		*/
+		glBindBuffer(GL_TEXTURE_BUFFER, lights_buffer_);
+		glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(1, lights.size()) * sizeof(dlb::LocalLight), nullptr, GL_STREAM_DRAW);
+		if (!lights.empty())
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, lights.size() * sizeof(dlb::LocalLight), lights.data());
+
+		glBindBuffer(GL_TEXTURE_BUFFER, grid_buffer_);
+		glBufferData(GL_TEXTURE_BUFFER, grid_.size() * sizeof(uint), grid_.data(), GL_STREAM_DRAW);
+
+		glBindBuffer(GL_TEXTURE_BUFFER, indices_buffer_);
+		glBufferData(GL_TEXTURE_BUFFER, indices_.size() * sizeof(uint), indices_.data(), GL_STREAM_DRAW);
+
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		glBindTexture(GL_TEXTURE_BUFFER, lights_texture_);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lights_buffer_);
+		glBindTexture(GL_TEXTURE_BUFFER, grid_texture_);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, grid_buffer_);
+		glBindTexture(GL_TEXTURE_BUFFER, indices_texture_);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, indices_buffer_);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	void ClusteredLighting::bind(const dlb::ShaderProgram& sp, const glm::vec2& viewport) const {
+		glActiveTexture(GL_TEXTURE0 + LIGHTS_UNIT);
+		glBindTexture(GL_TEXTURE_BUFFER, lights_texture_);
+		glActiveTexture(GL_TEXTURE0 + GRID_UNIT);
+		glBindTexture(GL_TEXTURE_BUFFER, grid_texture_);
+		glActiveTexture(GL_TEXTURE0 + INDICES_UNIT);
+		glBindTexture(GL_TEXTURE_BUFFER, indices_texture_);
+		glActiveTexture(GL_TEXTURE0);
+
+		const float log_ratio = std::log(frustum_.w / frustum_.z);
+
+		sp.setUniform("u_lights", LIGHTS_UNIT);
+		sp.setUniform("u_cluster_grid", GRID_UNIT);
+		sp.setUniform("u_light_indices", INDICES_UNIT);
+		sp.setUniform("u_cluster_dims", glm::vec3(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z));
+		// slice = log(depth) * scale - bias
+		sp.setUniform("u_cluster_z", glm::vec2(CLUSTERS_Z / log_ratio, CLUSTERS_Z * std::log(frustum_.z) / log_ratio));
+		sp.setUniform("u_viewport", viewport);
+	}
+}
@@ -0,0 +1,334 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string_view>
+
+#include "scene/ImportCache.hpp"
+#include "io/VirtualFileSystem.hpp"
+
+namespace scene {
+	/*
+	* 64 bit hash, 8 bytes per step, good enough to address a local cache.
+	*/
+	static u64 hashBytes(const unsigned char* data, size_t size, u64 hash) {
+		constexpr u64 MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+		size_t i = 0;
+
+		for (; i + 8 <= size; i += 8) {
+			u64 word;
+			std::memcpy(&word, data + i, 8);
+			hash = (hash ^ word) * MULTIPLIER;
+			hash ^= hash >> 29;
+		}
+
+		for (; i < size; i++)
+			hash = (hash ^ data[i]) * 0x100000001B3ull;
+
+		// the length tells "ab" + "c" from "a" + "bc"
+		hash = (hash ^ size) * MULTIPLIER;
+		return hash ^ (hash >> 32);
+	}
+
+	static u64 hashFile(const std::string& path, u64 hash) {
+		const dlb::FileView file = dlb::FileReader::open(path);
+
+		if (!file)
+			return hashBytes((const unsigned char*)path.data(), path.size(), hash);
+
+		return hashBytes(file.data(), file.size(), hash);
+	}
+
+	/*
+	* `mtllib` statements of an OBJ, the material libraries change the import.
+	*/
+	static std::vector<std::string> objDependencies(const dlb::FileView& file) {
+		std::vector<std::string> libraries{};
+		std::string_view text{ (const char*)file.data(), file.size() };
+
+		size_t line = 0;
+
+		while (line < text.size()) {
+			size_t end = text.find('\n', line);
+
+			if (end == std::string_view::npos)
+				end = text.size();
+
+			std::string_view statement = text.substr(line, end - line);
+
+			if (statement.starts_with("mtllib")) {
+				statement.remove_prefix(6);
+
+				while (!statement.empty() && (statement.front() == ' ' || statement.front() == '\t'))
+					statement.remove_prefix(1);
+
+				while (!statement.empty() && (statement.back() == '\r' || statement.back() == ' '))
+					statement.remove_suffix(1);
+
+				if (!statement.empty())
+					libraries.emplace_back(statement);
+			}
+
+			line = end + 1;
+		}
+
+		return libraries;
+	}
+
+	/*
+	* Size and modification time of a loose file, packed files have no stamp.
+	*/
+	struct FileStamp {
+		std::string path;
+		u64 size = 0;
+		long long time = 0;
+	};
+
+	static bool statFile(const std::string& path, FileStamp& stamp) {
+		auto& vfs = dlb::VirtualFileSystem::getInstance();
+
+		if (vfs.isPacked(path))
+			return false;
+
+		const std::string file = vfs.resolve(path);
+		std::error_code error{};
+
+		stamp.path = path;
+		stamp.size = std::filesystem::file_size(file, error);
+
+		if (error)
+			return false;
+
+		stamp.time = std::filesystem::last_write_time(file, error).time_since_epoch().count();
+		return !error;
+	}
+
+	static std::string toHex(u64 hash) {
+		char name[17];
+		std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+		return name;
+	}
+
+	/*
+	* The key of the last hash when the stamps of every file still match.
+	*/
+	static std::string readStamps(const std::string& path) {
+		std::ifstream file{ path };
+		std::string key{};
+
+		if (!file.is_open() || !std::getline(file, key) || key.empty())
+			return {};
+
+		FileStamp recorded{};
+		bool any = false;
+
+		while (file >> recorded.size >> recorded.time && file.get() == ' ' && std::getline(file, recorded.path)) {
+			FileStamp current{};
+
+			if (!statFile(recorded.path, current) || current.size != recorded.size || current.time != recorded.time)
+				return {};
+
+			any = true;
+		}
+
+		return any ? key : std::string{};
+	}
+
+	static void writeStamps(const std::string& path, const std::string& key, const std::vector<FileStamp>& stamps) {
+		const std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+		{
+			std::ofstream file{ temporary, std::ios::trunc };
+
+			if (!file.is_open())
+				return;
+
+			file << key << "\n";
+
+			for (const auto& stamp : stamps)
+				file << stamp.size << " " << stamp.time << " " << stamp.path << "\n";
+
+			if (!file.good())
+				return;
+		}
+
+		std::error_code error{};
+		std::filesystem::rename(temporary, path, error);
+
+		if (error)
+			std::filesystem::remove(temporary, error);
+	}
+
+	void ImportCache::configure(const std::string& directory, u64 max_bytes) {
+		directory_ = directory;
+		max_bytes_ = max_bytes;
+
+		if (directory_.empty())
+			return;
+
+		std::error_code error{};
+		std::filesystem::create_directories(directory_, error);
+
+		if (error) {
+			std::cerr << "[IMPORTCACHE] Could not create " << directory_ << ", cache disabled" << std::endl;
+			directory_.clear();
+		}
+	}
+
+	std::string ImportCache::stampPath(const std::string& source) const {
+		const u64 hash = hashBytes((const unsigned char*)source.data(), source.size(), importerSignature());
+		return (std::filesystem::path(directory_) / (toHex(hash) + STAMP_EXTENSION)).string();
+	}
+
+	std::string ImportCache::key(const std::string& source) const {
+		const std::string stamp_path = isEnabled() ? stampPath(source) : std::string{};
+
+		// unchanged since the last hash, no need to read the sources
+		if (!stamp_path.empty()) {
+			std::string key = readStamps(stamp_path);
+
+			// the modification time is the LRU stamp of collectGarbage
+			if (!key.empty()) {
+				std::error_code error{};
+				std::filesystem::last_write_time(stamp_path, std::filesystem::file_time_type::clock::now(), error);
+				return key;
+			}
+		}
+
+		// taken before hashing, a file changed in between only misses next time
+		std::vector<FileStamp> stamps(1);
+		bool stamped = statFile(source, stamps[0]);
+
+		const dlb::FileView file = dlb::FileReader::open(source);
+
+		if (!file)
+			return {};
+
+		u64 hash = hashBytes(file.data(), file.size(), importerSignature());
+
+		// the format is part of the key, the same bytes may import differently
+		const std::string extension = std::filesystem::path(source).extension().string();
+		hash = hashBytes((const unsigned char*)extension.data(), extension.size(), hash);
+
+		if (extension == ".obj" || extension == ".OBJ") {
+			const std::string directory = source.substr(0, source.find_last_of("\\/") + 1);
+
+			for (const auto& library : objDependencies(file)) {
+				stamps.emplace_back();
+				stamped = statFile(directory + library, stamps.back()) && stamped;
+				hash = hashFile(directory + library, hash);
+			}
+		}
+
+		const std::string key = toHex(hash);
+
+		if (stamped && !stamp_path.empty())
+			writeStamps(stamp_path, key, stamps);
+
+		return key;
+	}
+
+	std::string ImportCache::entryPath(const std::string& key) const {
+		return (std::filesystem::path(directory_) / (key + MODEL_FILE_EXTENSION)).string();
+	}
+
+	bool ImportCache::load(const std::string& key, dlb::FileView& file, ModelView& model) const {
+		if (!isEnabled() || key.empty())
+			return false;
+
+		const std::string path = entryPath(key);
+		file = dlb::FileReader::open(path);
+
+		if (!file || !readModelFile(file, model)) {
+			file.close();
+			return false;
+		}
+
+		// the modification time is the LRU stamp of collectGarbage
+		std::error_code error{};
+		std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+		return true;
+	}
+
+	void ImportCache::store(const std::string& key, const ModelView& model) {
+		if (!isEnabled() || key.empty())
+			return;
+
+		const std::string path = entryPath(key);
+		const std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+		if (!writeModelFile(temporary, model))
+			return;
+
+		std::error_code error{};
+		std::filesystem::rename(temporary, path, error);
+
+		if (error) {
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+
+		collectGarbage();
+	}
+
+	// longer than any store() takes to write an entry
+	static constexpr auto TEMPORARY_GRACE = std::chrono::hours(1);
+
+	void ImportCache::collectGarbage() {
+		if (!isEnabled() || max_bytes_ == 0)
+			return;
+
+		std::lock_guard lock{ gc_mutex_ };
+
+		struct Entry {
+			std::filesystem::file_time_type time;
+			u64 size;
+			std::filesystem::path path;
+		};
+
+		std::vector<Entry> entries{};
+		u64 total = 0;
+		std::error_code error{};
+
+		const auto now = std::filesystem::file_time_type::clock::now();
+
+		for (const auto& file : std::filesystem::directory_iterator(directory_, error)) {
+			if (!file.is_regular_file(error))
+				continue;
+
+			// another store() may still be writing it, only ones left by a crash are removed
+			if (file.path().extension() == ".tmp") {
+				if (file.last_write_time(error) + TEMPORARY_GRACE < now)
+					std::filesystem::remove(file.path(), error);
+
+				continue;
+			}
+
+			entries.push_back({ file.last_write_time(error), file.file_size(error), file.path() });
+			total += entries.back().size;
+		}
+
+		if (total <= max_bytes_)
+			return;
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+			return a.time < b.time;
+		});
+
+		for (const auto& entry : entries) {
+			if (total <= max_bytes_)
+				break;
+
+			if (std::filesystem::remove(entry.path, error)) {
+				total -= entry.size;
+				std::cout << "[IMPORTCACHE] Evicted " << entry.path.filename().string() << std::endl;
+			}
+		}
+	}
+}
@@ -1,19 +1,71 @@
 #include <iostream>
 #include <format>
+#include <climits>
+#include <filesystem>
+#include <algorithm>
 
 #include "scene/Model.hpp"
+#include "scene/ImportCache.hpp"
 #include "Application.hpp"
+#include "profiling/CpuProfiler.hpp"
+#include "profiling/FrameStats.hpp"
+#include "profiling/LoadStats.hpp"
+#include "jobs/ThreadPool.hpp"
+#include "io/VirtualFileSystem.hpp"
 
 namespace scene {
-	void Model::draw(const dlb::ShaderProgram& sp, const glm::mat4& transformation, const glm::vec3& bb_color = {0.0f, 0.0f, 0.0f}) {
-		const auto& context = dlb::ApplicationSingleton::getInstance();
+	static void setLightingUniforms(const dlb::ShaderProgram& sp, const dlb::RenderSnapshot& frame) {
+		auto& context = dlb::ApplicationSingleton::getInstance();
+		const auto& light = frame.global_light;
 
-		for (auto& mesh : meshes_) {
-			mesh.draw(sp, transformation, flags_);
+		sp.setUniform("u_light.direction", light.direction);
+		sp.setUniform("u_light.ambient", light.ambient);
+		sp.setUniform("u_light.diffuse", light.diffuse);
+		sp.setUniform("u_light.specular", light.specular);
+		sp.setUniform("u_eye_position", frame.eye_position);
+
+		context.getClusteredLighting().bind(sp, frame.viewport);
+	}
+
+	void Model::draw(const dlb::ShaderProgram& sp, const dlb::RenderSnapshot& frame, const glm::mat4& transformation) {
+		PROFILE_ZONE("Model::draw");
+
+		if (!isResident())
+			return;
+
+		// the sampler units and the material block binding were set once, see MaterialTable::bindProgram
+		if ((flags_ & UseTextures) && (flags_ & PackTextures))
+			texture_arrays_.use(dlb::MaterialTable::ARRAY_UNIT);
+
+		sp.use();
+
+		// every mesh of the model shares the uniforms and the buffers
+		sp.setUniform("u_model", transformation);
+		sp.setUniform("u_view", frame.view);
+		sp.setUniform("u_projection", frame.projection);
+
+		setLightingUniforms(sp, frame);
+
+		geometry_.bind();
+
+		uint bound = UINT_MAX;
+
+		for (const auto& mesh : meshes_) {
+			if (mesh.getMaterialIndex() != bound) {
+				bound = mesh.getMaterialIndex();
+				materials_.bind(bound);
+			}
+
+			mesh.draw();
 		}
 
-		if ((flags_ & DrawAABB))
-			aabb_mesh_.draw(context.getShader(context.getAABBShader()), transformation, bb_color);
+		glBindVertexArray(0);
+
+		auto error = glGetError();
+
+		if (error != GL_NO_ERROR) {
+			dlb::ApplicationSingleton::getInstance().error(std::format("Error rendering model, glGetError returned {}.", error), __FILE__, __FUNCTION__);
+		}
 	}
 
 	bool Model::AABBTest(Model& other, const glm::vec3& this_position, const glm::vec3& other_position) {
@@ -26,183 +78,304 @@ namespace scene {
 		return thisAABB.test(otherAABB);
 	}
 
-	void Model::load_model(const char* path) {
-		Assimp::Importer importer;
-		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+	/*
+	* A cooked file older than its source is ignored, the source wins until
+	*	the model is cooked again. A packed cooked file is always up to date.
+	*/
+	static bool isCookedUpToDate(const std::string& source, const std::string& cooked) {
+		auto& vfs = dlb::VirtualFileSystem::getInstance();
 
-		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-			std::cerr << "Error: load_model: " << importer.GetErrorString() << std::endl;
-			error = true;
-			return;
-		}
+		if (vfs.isPacked(cooked))
+			return true;
 
-		const std::string p{ path };
+		std::error_code error{};
+		const std::string cooked_file = vfs.resolve(cooked);
 
-		directory_ = p.substr(0, p.find_last_of('\\') + 1);
-		process_node(scene->mRootNode, scene);
+		if (!std::filesystem::exists(cooked_file, error))
+			return false;
 
-		createAABB();
+		const std::string source_file = vfs.resolve(source);
 
-		if (flags_ & DrawAABB)
-			createAABBMesh();
+		// shipped without the loose source
+		if (!std::filesystem::exists(source_file, error))
+			return true;
+
+		return std::filesystem::last_write_time(cooked_file, error) >= std::filesystem::last_write_time(source_file, error);
 	}
 
-	void Model::process_node(aiNode* node, const aiScene* scene) { 
-		for (int i = 0; i < node->mNumMeshes; i++) {
-			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			meshes_.push_back(std::move(process_mesh(mesh, scene)));
-		}
+	void Model::import() {
+		PROFILE_ZONE("Model::import");
 
-		for (int i = 0; i < node->mNumChildren; i++)
-			process_node(node->mChildren[i], scene);
-	}
+		auto expected = ModelState::Queued;
+
+		if (!state_.compare_exchange_strong(expected, ModelState::Importing, std::memory_order_acq_rel))
+			return;
 
-	Mesh Model::process_mesh(aiMesh* mesh, const aiScene* scene) {
-		std::vector<Vertex> vertices{};
-		std::vector<uint> indices{};
-		std::vector<dlb::Texture2D> textures{};
+		directory_ = path_.substr(0, path_.find_last_of("\\/") + 1);
 
-		for (int i = 0; i < mesh->mNumVertices; i++) {
-			Vertex vert;
-			vert.position.x = mesh->mVertices[i].x;
-			vert.position.y = mesh->mVertices[i].y;
-			vert.position.z = mesh->mVertices[i].z;
+		// the texture decodes below are reported on their own
+		{
+			dlb::ScopedLoadTimer timer{ dlb::LoadPhase::ModelImport, path_ };
 
-			vert.normal.x = mesh->mNormals[i].x;
-			vert.normal.y = mesh->mNormals[i].y;
-			vert.normal.z = mesh->mNormals[i].z;
+			const std::string cooked = cookedModelPath(path_);
+			bool loaded = false;
 
+			if (isCookedUpToDate(path_, cooked)) {
+				cooked_ = dlb::FileReader::open(cooked);
+				loaded = cooked_ && readModelFile(cooked_, view_);
 
-			if (flags_ & ModelFlags::UseTextures) {
-				if (mesh->mTextureCoords[0]) {
-					vert.tex_coords.x = mesh->mTextureCoords[0][i].x;
-					vert.tex_coords.y = mesh->mTextureCoords[0][i].y;
+				if (!loaded) {
+					cooked_.close();
+					std::cerr << "[MODEL] Could not read " << cooked << ", importing " << path_ << std::endl;
 				}
-				else {
-					vert.tex_coords = { 0.0f, 0.0f };
+			}
+
+			auto& cache = ImportCache::getInstance();
+			const std::string key = !loaded && cache.isEnabled() ? cache.key(path_) : std::string{};
+
+			if (!loaded)
+				loaded = cache.load(key, cooked_, view_);
+
+			if (!loaded) {
+				if (!importModel(path_, imported_)) {
+					error = true;
+					state_.store(ModelState::Failed, std::memory_order_release);
+					return;
 				}
+
+				view_ = imported_.view();
+
+				// the next start maps it instead
+				cache.store(key, view_);
 			}
 
-			vertices.push_back(vert);
+			timer.addBytesRead(cooked_ ? cooked_.size() : dlb::FileReader::open(path_).size());
 		}
 
-		for (int i = 0; i < mesh->mNumFaces; i++) {
-			aiFace face = mesh->mFaces[i];
-			for (int j = 0; j < face.mNumIndices; j++)
-				indices.push_back(face.mIndices[j]);
-		}
+		bounds_ = { view_.min, view_.max };
 
-		dlb::Texture2DGroupBuilder tex_group_builder{};
+		prepareTextures();
 
-		Material mat{};
+		state_.store(ModelState::Imported, std::memory_order_release);
+	}
 
-		if (mesh->mMaterialIndex >= 0) {
-			aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+	void Model::prepareTextures() {
+		if (!(flags_ & UseTextures))
+			return;
 
-			if (flags_ & UseMaterials)
-				mat = process_material(material, scene);
+		PROFILE_ZONE("Model::decodeTextures");
 
-			else if (flags_ & UseTextures) {
-				load_material_textures(tex_group_builder, material, aiTextureType_DIFFUSE);
-				load_material_textures(tex_group_builder, material, aiTextureType_SPECULAR);
+		if (flags_ & PackTextures) {
+			texture_slots_.assign(view_.materials.size(), { -1, -1 });
+
+			// only the first texture of each type is sampled by the packed shader
+			for (uint i = 0; i < view_.materials.size(); i++) {
+				const auto& material = view_.materials[i];
+
+				for (const auto& texture : view_.textures.subspan(material.first_texture, material.texture_count)) {
+					if (texture.type != dlb::Texture2DType::Diffuse && texture.type != dlb::Texture2DType::Specular)
+						continue;
+
+					int& slot = texture.type == dlb::Texture2DType::Diffuse ? texture_slots_[i].first : texture_slots_[i].second;
+
+					if (slot < 0)
+						slot = texture_packer_.add(directory_ + std::string(view_.texturePath(texture)));
+				}
 			}
+
+			texture_packer_.decode();
+			return;
 		}
 
-		return Mesh(std::move(vertices), std::move(indices), tex_group_builder.build(), mat);
+		texture_builders_.resize(view_.materials.size());
+
+		for (uint i = 0; i < view_.materials.size(); i++) {
+			const auto& material = view_.materials[i];
+			auto& builder = texture_builders_[i];
+
+			for (const auto& texture : view_.textures.subspan(material.first_texture, material.texture_count)) {
+				// normal maps are cooked (BC5) but not sampled by the model shader yet
+				if (texture.type == dlb::Texture2DType::Normal)
+					continue;
+
+				builder.configure_new()
+					.path(directory_ + std::string(view_.texturePath(texture)))
+					.type((dlb::Texture2DType)texture.type);
+			}
+		}
+
+		// every texture of every material in flight at once, the builders fan out again
+		dlb::ThreadPool::getInstance().parallelFor(texture_builders_.size(), 1, [this](uint begin, uint end) {
+			for (uint i = begin; i < end; i++)
+				texture_builders_[i].decode();
+		});
 	}
 
-	Material Model::process_material(aiMaterial* material, const aiScene* scene) {
-		Material mat{};
+	bool Model::uploadSlice(dlb::StagingBuffer* staging, u64 deadline) {
+		PROFILE_ZONE("Model::uploadSlice");
+
+		auto state = getState();
 
-		aiColor3D color{ 0.0f };
+		if (state == ModelState::Resident || state == ModelState::Failed)
+			return true;
 
-		material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-		mat.diffuse = { color.r, color.g, color.b };
-		
-		material->Get(AI_MATKEY_COLOR_AMBIENT, color);
-		mat.ambient = { color.r, color.g, color.b };
+		// still importing
+		if (state != ModelState::Imported)
+			return false;
 
-		material->Get(AI_MATKEY_COLOR_SPECULAR, color);
-		mat.specular = { color.r, color.g, color.b };
+		do {
+			switch (upload_step_) {
+			case UploadStep::Geometry:
+				uploadGeometrySlice();
+				break;
 
-		float shininess{ 0.0f };
+			case UploadStep::Textures:
+				uploadTextureSlice(staging);
+				break;
 
-		material->Get(AI_MATKEY_SHININESS, shininess);
-		mat.shininess = shininess;
+			case UploadStep::Materials:
+				finishUpload();
+				return true;
+			}
+		} while (dlb::FrameStats::nowNs() < deadline);
 
-		return mat;
+		return false;
 	}
 
-	void Model::load_material_textures(dlb::Texture2DGroupBuilder& builder, aiMaterial* material, aiTextureType type) {
-		for (int i = 0; i < material->GetTextureCount(type); i++) {
-			aiString path;
-			material->GetTexture(type, i, &path);
-			builder.configure_new()
-				.path(std::format("{}{}", directory_, path.C_Str()))
-				.type((type == aiTextureType_DIFFUSE) ? dlb::Texture2DType::Diffuse : dlb::Texture2DType::Specular);
+	// bytes copied by one geometry slice
+	static constexpr size_t GEOMETRY_SLICE_BYTES = 1 << 20;
+
+	void Model::uploadGeometrySlice() {
+		const size_t vertex_bytes = view_.vertices.size_bytes();
+		const size_t index_bytes = view_.indices.size_bytes();
+
+		// one entry per model, the slices add up
+		dlb::ScopedLoadTimer timer{ dlb::LoadPhase::BufferUpload, path_ };
+		const size_t uploaded = upload_offset_;
+
+		if (upload_offset_ == 0)
+			geometry_.allocate<Vertex>(vertex_bytes, index_bytes);
+
+		// the vertices first, then the indices, as one range of offsets
+		if (upload_offset_ < vertex_bytes) {
+			size_t bytes = std::min(GEOMETRY_SLICE_BYTES, vertex_bytes - upload_offset_);
+			geometry_.uploadVertices(upload_offset_, (const char*)view_.vertices.data() + upload_offset_, bytes);
+			upload_offset_ += bytes;
+		}
+		else if (upload_offset_ < vertex_bytes + index_bytes) {
+			size_t offset = upload_offset_ - vertex_bytes;
+			size_t bytes = std::min(GEOMETRY_SLICE_BYTES, index_bytes - offset);
+			geometry_.uploadIndices(offset, (const char*)view_.indices.data() + offset, bytes);
+			upload_offset_ += bytes;
 		}
+
+		timer.addBytesUploaded(upload_offset_ - uploaded);
+
+		if (upload_offset_ >= vertex_bytes + index_bytes)
+			upload_step_ = (flags_ & UseTextures) ? UploadStep::Textures : UploadStep::Materials;
 	}
 
-	void Model::createAABB() {
-		glm::vec3 min{ std::numeric_limits<float>::infinity() };
-		glm::vec3 max{ -std::numeric_limits<float>::infinity()};
+	void Model::uploadTextureSlice(dlb::StagingBuffer* staging) {
+		PROFILE_ZONE("Model::uploadTextures");
 
-		for (int i = 0; i < meshes_.size(); i++) {
-			auto current_min = meshes_[i].getMinCoords();
-			auto current_max = meshes_[i].getMaxCoords();
+		if (flags_ & PackTextures) {
+			// one array layer or atlas page per slice
+			if (!texture_packer_.uploadNext(staging))
+				return;
 
-			if (min.x > current_min.x)
-				min.x = current_min.x;
+			texture_arrays_ = texture_packer_.build(staging);
+
+			for (auto [diffuse, specular] : texture_slots_) {
+				material_layers_.push_back({
+					diffuse >= 0 ? texture_packer_.layer(diffuse) : dlb::Texture2DLayer{},
+					specular >= 0 ? texture_packer_.layer(specular) : dlb::Texture2DLayer{},
+				});
+			}
+
+			upload_step_ = UploadStep::Materials;
+			return;
+		}
 
-			if (min.y > current_min.y)
-				min.y = current_min.y;
+		// one texture per slice, a material's group is complete after its last one
+		if (upload_material_ < texture_builders_.size()) {
+			auto& builder = texture_builders_[upload_material_];
 
-			if (min.z > current_min.z)
-				min.z = current_min.z;
+			if (builder.uploadNext(staging)) {
+				material_textures_.push_back(builder.build(staging));
+				upload_material_++;
+			}
+		}
 
-			if (max.x < current_max.x)
-				max.x = current_max.x;
+		if (upload_material_ >= texture_builders_.size())
+			upload_step_ = UploadStep::Materials;
+	}
 
-			if (max.y < current_max.y)
-				max.y = current_max.y;
+	void Model::finishUpload() {
+		std::vector<uint> table_indices{};
 
-			if (max.z < current_max.z)
-				max.z = current_max.z;
+		{
+			dlb::ScopedLoadTimer timer{ dlb::LoadPhase::BufferUpload, path_ };
+			compileMaterials(table_indices);
+			timer.addBytesUploaded(materials_.getBufferBytes());
 		}
 
-		aabb_.min = min;
-		aabb_.max = max;
+		meshes_.reserve(view_.meshes.size());
+
+		for (const auto& mesh : view_.meshes)
+			meshes_.emplace_back(mesh, table_indices[mesh.material]);
+
+		// the GPU has its copy now
+		view_ = {};
+		cooked_.close();
+		imported_ = {};
+		std::vector<dlb::Texture2DGroupBuilder>{}.swap(texture_builders_);
+		texture_packer_ = dlb::Texture2DArrayPacker{};
+		std::vector<std::pair<int, int>>{}.swap(texture_slots_);
+
+		state_.store(ModelState::Resident, std::memory_order_release);
 	}
-	void Model::createAABBMesh() {
-		auto& m = aabb_.max;
-		auto& i = aabb_.min;
-
-		std::vector<BasicVertex> verts = {
-			{glm::vec3(m.x, m.y, m.z)}, // m
-			{glm::vec3(i.x, i.y, i.z)}, // i
-			{glm::vec3(m.x, i.y, m.z)}, // a
-			{glm::vec3(i.x, i.y, m.z)}, // b
-			{glm::vec3(i.x, m.y, m.z)}, // c
-			{glm::vec3(i.x, m.y, i.z)}, // d
-			{glm::vec3(m.x, m.y, i.z)}, // e
-			{glm::vec3(m.x, i.y, i.z)}, // f
-		};
-
-		std::vector<uint> indices = {
-			0,2,3, //m a b
-			0,4,3, //m c b
-			0,2,7, 
-			0,6,7,
-			0,4,5,
-			0,5,6,
-			1,3,4,
-			1,4,5,
-			1,7,6,
-			1,6,5,
-			1,3,2,
-			1,7,2,
-		};
-
-		aabb_mesh_.feed(std::move(verts), std::move(indices));
+
+	void Model::compileMaterials(std::vector<uint>& table_indices) {
+		for (uint i = 0; i < view_.materials.size(); i++) {
+			const auto& material = view_.materials[i];
+
+			dlb::MaterialConstants constants{};
+
+			// files without a shininess keep the default exponent
+			if (material.shininess > 0.0f)
+				constants.shininess = material.shininess;
+
+			if ((flags_ & UseTextures) && (flags_ & PackTextures)) {
+				const auto& [diffuse, specular] = material_layers_[i];
+				constants.layers = { diffuse.array, diffuse.layer, specular.array, specular.layer };
+				constants.diffuse_rect = diffuse.uv_rect;
+				constants.specular_rect = specular.uv_rect;
+				table_indices.push_back(materials_.add(constants));
+			}
+			else if (flags_ & UseTextures) {
+				std::vector<dlb::MaterialTexture> textures{};
+				uint n_diffuse = 0;
+				uint n_specular = 0;
+
+				// the shader declares MAX_TEXTURES samplers of each type
+				for (const auto& texture : material_textures_[i].getTextures()) {
+					if (texture.type == dlb::Texture2DType::Diffuse && n_diffuse < dlb::MaterialTable::MAX_TEXTURES)
+						textures.push_back({ dlb::MaterialTable::DIFFUSE_UNIT + n_diffuse++, texture.id });
+
+					else if (texture.type == dlb::Texture2DType::Specular && n_specular < dlb::MaterialTable::MAX_TEXTURES)
+						textures.push_back({ dlb::MaterialTable::SPECULAR_UNIT + n_specular++, texture.id });
+				}
+
+				table_indices.push_back(materials_.add(constants, textures));
+			}
+			else {
+				constants.ambient = glm::vec4(material.ambient, 1.0f);
+				constants.diffuse = glm::vec4(material.diffuse, 1.0f);
+				constants.specular = glm::vec4(material.specular, 1.0f);
+				table_indices.push_back(materials_.add(constants));
+			}
+		}
+
+		materials_.upload();
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,150 @@
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <filesystem>
+
+#include "scene/ModelFile.hpp"
+
+namespace scene {
+	static constexpr u64 SECTION_ALIGNMENT = 16;
+
+	std::string cookedModelPath(const std::string& path) {
+		return std::filesystem::path(path).replace_extension(MODEL_FILE_EXTENSION).string();
+	}
+
+	static u64 alignSection(u64 offset) {
+		return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+	}
+
+	bool writeModelFile(const std::string& path, const ModelView& model) {
+		const std::span<const unsigned char> sections[MODEL_FILE_SECTIONS] = {
+			std::span((const unsigned char*)model.vertices.data(), model.vertices.size_bytes()),
+			std::span((const unsigned char*)model.indices.data(), model.indices.size_bytes()),
+			std::span((const unsigned char*)model.meshes.data(), model.meshes.size_bytes()),
+			std::span((const unsigned char*)model.materials.data(), model.materials.size_bytes()),
+			std::span((const unsigned char*)model.textures.data(), model.textures.size_bytes()),
+			std::span((const unsigned char*)model.strings.data(), model.strings.size()),
+		};
+
+		const u64 counts[MODEL_FILE_SECTIONS] = {
+			model.vertices.size(), model.indices.size(), model.meshes.size(),
+			model.materials.size(), model.textures.size(), model.strings.size(),
+		};
+
+		ModelFileHeader header{};
+		std::memcpy(header.magic, MODEL_FILE_MAGIC, sizeof(header.magic));
+		header.version = MODEL_FILE_VERSION;
+		header.vertex_size = sizeof(Vertex);
+		header.min = model.min;
+		header.max = model.max;
+		header.importer = importerSignature();
+
+		u64 offset = alignSection(sizeof(ModelFileHeader));
+
+		for (int i = 0; i < MODEL_FILE_SECTIONS; i++) {
+			header.sections[i][0] = offset;
+			header.sections[i][1] = counts[i];
+			offset = alignSection(offset + sections[i].size());
+		}
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+
+		if (!file.is_open()) {
+			std::cerr << "[MODELFILE] Could not open " << path << " for writing" << std::endl;
+			return false;
+		}
+
+		static const char padding[SECTION_ALIGNMENT] = {};
+
+		file.write((const char*)&header, sizeof(header));
+		u64 written = sizeof(header);
+
+		for (int i = 0; i < MODEL_FILE_SECTIONS; i++) {
+			file.write(padding, header.sections[i][0] - written);
+			file.write((const char*)sections[i].data(), sections[i].size());
+			written = header.sections[i][0] + sections[i].size();
+		}
+
+		if (!file.good()) {
+			std::cerr << "[MODELFILE] Could not write " << path << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	template<typename T>
+	static bool mapSection(const dlb::FileView& file, const ModelFileHeader& header, ModelFileSection section, std::span<const T>& out) {
+		const u64 offset = header.sections[(int)section][0];
+		const u64 count = header.sections[(int)section][1];
+
+		if (offset % alignof(T) != 0 || offset > file.size() || count > (file.size() - offset) / sizeof(T))
+			return false;
+
+		out = std::span<const T>((const T*)(file.data() + offset), count);
+		return true;
+	}
+
+	bool readModelFile(const dlb::FileView& file, ModelView& model) {
+		if (file.size() < sizeof(ModelFileHeader))
+			return false;
+
+		ModelFileHeader header{};
+		std::memcpy(&header, file.data(), sizeof(header));
+
+		if (std::memcmp(header.magic, MODEL_FILE_MAGIC, sizeof(header.magic)) != 0) {
+			std::cerr << "[MODELFILE] Not a cooked model" << std::endl;
+			return false;
+		}
+
+		if (header.version != MODEL_FILE_VERSION || header.vertex_size != sizeof(Vertex)) {
+			std::cerr << "[MODELFILE] Cooked model version " << header.version << ", expected " << MODEL_FILE_VERSION << ", cook it again" << std::endl;
+			return false;
+		}
+
+		// converted differently than the current importer would, welding or texture types may be missing
+		if (header.importer != importerSignature()) {
+			std::cerr << "[MODELFILE] Cooked by another importer, cook it again" << std::endl;
+			return false;
+		}
+
+		std::span<const char> strings{};
+
+		bool valid =
+			mapSection(file, header, ModelFileSection::Vertices, model.vertices) &&
+			mapSection(file, header, ModelFileSection::Indices, model.indices) &&
+			mapSection(file, header, ModelFileSection::Meshes, model.meshes) &&
+			mapSection(file, header, ModelFileSection::Materials, model.materials) &&
+			mapSection(file, header, ModelFileSection::Textures, model.textures) &&
+			mapSection(file, header, ModelFileSection::Strings, strings);
+
+		// the ranges are trusted by Model, a truncated or corrupt file is rejected here
+		for (const auto& mesh : model.meshes) {
+			valid = valid &&
+				(u64)mesh.first_vertex + mesh.vertex_count <= model.vertices.size() &&
+				(u64)mesh.first_index + mesh.index_count <= model.indices.size() &&
+				mesh.material < model.materials.size();
+
+			// drawn with the mesh's first vertex as base, an index past its vertices reads beyond the buffer
+			for (uint i = 0; valid && i < mesh.index_count; i++)
+				valid = model.indices[mesh.first_index + i] < mesh.vertex_count;
+		}
+
+		for (const auto& material : model.materials)
+			valid = valid && (u64)material.first_texture + material.texture_count <= model.textures.size();
+
+		for (const auto& texture : model.textures)
+			valid = valid && (u64)texture.path_offset + texture.path_length <= strings.size();
+
+		if (!valid) {
+			std::cerr << "[MODELFILE] Cooked model is truncated or corrupt" << std::endl;
+			return false;
+		}
+
+		model.strings = std::string_view(strings.data(), strings.size());
+		model.min = header.min;
+		model.max = header.max;
+
+		return true;
+	}
+}
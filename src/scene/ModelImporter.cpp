@@ -0,0 +1,373 @@
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/version.h>
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+#include "scene/ModelFile.hpp"
+#include "Texture.hpp"
+#include "jobs/ThreadPool.hpp"
+#include "io/VirtualFileSystem.hpp"
+#include "io/FileReader.hpp"
+
+namespace scene {
+	/*
+	* A whole file opened through dlb::FileReader, borrowed from the pack
+	*	mapping or mapped from disk.
+	*/
+	class VfsStream : public Assimp::IOStream {
+	public:
+		explicit VfsStream(dlb::FileView&& file)
+			:file_(std::move(file)) {
+		}
+
+		size_t Read(void* buffer, size_t size, size_t count) override {
+			if (size == 0)
+				return 0;
+
+			count = std::min(count, (file_.size() - position_) / size);
+			std::memcpy(buffer, file_.data() + position_, size * count);
+			position_ += size * count;
+
+			return count;
+		}
+
+		size_t Write(const void*, size_t, size_t) override {
+			return 0;
+		}
+
+		aiReturn Seek(size_t offset, aiOrigin origin) override {
+			const size_t base = origin == aiOrigin_SET ? 0 : origin == aiOrigin_CUR ? position_ : file_.size();
+
+			if (offset > file_.size() - base)
+				return aiReturn_FAILURE;
+
+			position_ = base + offset;
+			return aiReturn_SUCCESS;
+		}
+
+		size_t Tell() const override {
+			return position_;
+		}
+
+		size_t FileSize() const override {
+			return file_.size();
+		}
+
+		void Flush() override {}
+
+	private:
+		dlb::FileView file_;
+		size_t position_ = 0;
+	};
+
+	/*
+	* Lets assimp open `res://` paths, the model and the files it references
+	*	(OBJ material libraries) load from the pack as well. Read only.
+	*/
+	class VfsSystem : public Assimp::IOSystem {
+	public:
+		bool Exists(const char* path) const override {
+			return dlb::VirtualFileSystem::getInstance().exists(path);
+		}
+
+		char getOsSeparator() const override {
+			return '/';
+		}
+
+		Assimp::IOStream* Open(const char* path, const char* mode) override {
+			if (std::strchr(mode, 'w') || std::strchr(mode, 'a'))
+				return nullptr;
+
+			dlb::FileView file = dlb::FileReader::open(path);
+
+			if (!file)
+				return nullptr;
+
+			return new VfsStream(std::move(file));
+		}
+
+		void Close(Assimp::IOStream* stream) override {
+			delete stream;
+		}
+	};
+
+	static dlb::Texture2DType textureType(aiTextureType type) {
+		switch (type) {
+		case aiTextureType_DIFFUSE: return dlb::Texture2DType::Diffuse;
+		case aiTextureType_SPECULAR: return dlb::Texture2DType::Specular;
+		// OBJ map_Bump is imported as a height map, in practice it holds normals
+		case aiTextureType_NORMALS:
+		case aiTextureType_HEIGHT: return dlb::Texture2DType::Normal;
+		default: return dlb::Texture2DType::Whatever;
+		}
+	}
+
+	static void importMaterialTextures(ModelData& model, aiMaterial* material, aiTextureType type) {
+		for (uint i = 0; i < material->GetTextureCount(type); i++) {
+			aiString path;
+			material->GetTexture(type, i, &path);
+
+			const std::string_view name{ path.C_Str() };
+
+			model.textures.push_back({
+				(uint)model.strings.size(),
+				(uint)name.size(),
+				(uint)textureType(type),
+			});
+
+			model.strings.append(name);
+		}
+	}
+
+	static MaterialRecord importMaterial(ModelData& model, aiMaterial* material) {
+		MaterialRecord record{};
+
+		aiColor3D color{ 0.0f };
+
+		material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
+		record.diffuse = { color.r, color.g, color.b };
+
+		material->Get(AI_MATKEY_COLOR_AMBIENT, color);
+		record.ambient = { color.r, color.g, color.b };
+
+		material->Get(AI_MATKEY_COLOR_SPECULAR, color);
+		record.specular = { color.r, color.g, color.b };
+
+		float shininess{ 0.0f };
+
+		material->Get(AI_MATKEY_SHININESS, shininess);
+		record.shininess = shininess;
+
+		record.first_texture = model.textures.size();
+		importMaterialTextures(model, material, aiTextureType_DIFFUSE);
+		importMaterialTextures(model, material, aiTextureType_SPECULAR);
+		importMaterialTextures(model, material, aiTextureType_NORMALS);
+		importMaterialTextures(model, material, aiTextureType_HEIGHT);
+		record.texture_count = model.textures.size() - record.first_texture;
+
+		return record;
+	}
+
+	/*
+	* Fills the ranges of `record` that importModel reserved for this mesh,
+	*	touches nothing shared so meshes convert in parallel.
+	*/
+	static void convertMesh(ModelData& model, const aiMesh* mesh, MeshRecord& record) {
+		record.min = glm::vec3(std::numeric_limits<float>::infinity());
+		record.max = glm::vec3(-std::numeric_limits<float>::infinity());
+
+		Vertex* vertices = model.vertices.data() + record.first_vertex;
+
+		for (uint i = 0; i < mesh->mNumVertices; i++) {
+			Vertex& vert = vertices[i];
+			vert.position = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
+			vert.normal = mesh->mNormals ? glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z) : glm::vec3(0.0f);
+			vert.tex_coords = mesh->mTextureCoords[0] ? glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y) : glm::vec2(0.0f);
+
+			record.min = glm::min(record.min, vert.position);
+			record.max = glm::max(record.max, vert.position);
+		}
+
+		uint* indices = model.indices.data() + record.first_index;
+
+		for (uint i = 0; i < mesh->mNumFaces; i++) {
+			const aiFace& face = mesh->mFaces[i];
+			indices = std::copy(face.mIndices, face.mIndices + face.mNumIndices, indices);
+		}
+	}
+
+	static uint countIndices(const aiMesh* mesh) {
+		// aiProcess_Triangulate leaves only triangles in most meshes
+		if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+			return mesh->mNumFaces * 3;
+
+		uint count = 0;
+
+		for (uint i = 0; i < mesh->mNumFaces; i++)
+			count += mesh->mFaces[i].mNumIndices;
+
+		return count;
+	}
+
+	/*
+	* Every mesh reference in node order, a mesh referenced twice is imported
+	*	twice and folded again by shareIdenticalMeshes.
+	*/
+	static void collectNode(const aiScene* scene, aiNode* node, std::vector<const aiMesh*>& meshes) {
+		for (uint i = 0; i < node->mNumMeshes; i++)
+			meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+
+		for (uint i = 0; i < node->mNumChildren; i++)
+			collectNode(scene, node->mChildren[i], meshes);
+	}
+
+	static bool samePayload(const ModelData& model, const MeshRecord& a, const MeshRecord& b) {
+		return a.vertex_count == b.vertex_count && a.index_count == b.index_count &&
+			std::memcmp(&model.vertices[a.first_vertex], &model.vertices[b.first_vertex], a.vertex_count * sizeof(Vertex)) == 0 &&
+			std::memcmp(&model.indices[a.first_index], &model.indices[b.first_index], a.index_count * sizeof(uint)) == 0;
+	}
+
+	/*
+	* Meshes with byte identical vertices and indices point at the ranges of
+	*	the first one, the copies are dropped from the blobs so they are
+	*	uploaded once and share its buffers.
+	*/
+	static void shareIdenticalMeshes(ModelData& model) {
+		const uint mesh_count = model.meshes.size();
+
+		std::vector<size_t> hashes(mesh_count);
+
+		dlb::ThreadPool::getInstance().parallelFor(mesh_count, 1, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++) {
+				const auto& record = model.meshes[i];
+				const std::string_view vertices{ (const char*)&model.vertices[record.first_vertex], record.vertex_count * sizeof(Vertex) };
+				const std::string_view indices{ (const char*)&model.indices[record.first_index], record.index_count * sizeof(uint) };
+
+				hashes[i] = std::hash<std::string_view>{}(vertices) * 31 + std::hash<std::string_view>{}(indices);
+			}
+		});
+
+		// mesh -> the mesh whose payload it reuses, itself for the first copy
+		std::vector<uint> source(mesh_count);
+		std::unordered_map<size_t, std::vector<uint>> first_copies{};
+		bool shared = false;
+
+		for (uint i = 0; i < mesh_count; i++) {
+			source[i] = i;
+
+			auto& candidates = first_copies[hashes[i]];
+
+			for (uint candidate : candidates) {
+				if (samePayload(model, model.meshes[candidate], model.meshes[i])) {
+					source[i] = candidate;
+					shared = true;
+					break;
+				}
+			}
+
+			if (source[i] == i)
+				candidates.push_back(i);
+		}
+
+		if (!shared)
+			return;
+
+		std::vector<Vertex> vertices{};
+		std::vector<uint> indices{};
+
+		for (uint i = 0; i < mesh_count; i++) {
+			auto& record = model.meshes[i];
+
+			// the first copy was compacted already, it comes earlier
+			if (source[i] != i) {
+				const auto& first = model.meshes[source[i]];
+				record.first_vertex = first.first_vertex;
+				record.first_index = first.first_index;
+				continue;
+			}
+
+			const uint first_vertex = vertices.size();
+			const uint first_index = indices.size();
+
+			vertices.insert(vertices.end(), model.vertices.begin() + record.first_vertex, model.vertices.begin() + record.first_vertex + record.vertex_count);
+			indices.insert(indices.end(), model.indices.begin() + record.first_index, model.indices.begin() + record.first_index + record.index_count);
+
+			record.first_vertex = first_vertex;
+			record.first_index = first_index;
+		}
+
+		model.vertices = std::move(vertices);
+		model.indices = std::move(indices);
+	}
+
+	/*
+	* JoinIdenticalVertices welds the vertices the source format duplicates
+	*	per face (OBJ corners, flat exports), meshes are indexed afterwards.
+	*/
+	static constexpr uint IMPORT_PROCESS_FLAGS = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs;
+
+	u64 importerSignature() {
+		const u64 parts[] = {
+			aiGetVersionMajor(), aiGetVersionMinor(), aiGetVersionRevision(),
+			IMPORT_PROCESS_FLAGS, IMPORTER_VERSION, MODEL_FILE_VERSION, sizeof(Vertex),
+		};
+
+		u64 signature = 0xCBF29CE484222325ull;
+
+		for (u64 part : parts)
+			signature = (signature ^ part) * 0x100000001B3ull;
+
+		return signature;
+	}
+
+	bool importModel(const std::string& path, ModelData& model) {
+		Assimp::Importer importer;
+		// owned by the importer
+		importer.SetIOHandler(new VfsSystem{});
+
+		const aiScene* scene = importer.ReadFile(path, IMPORT_PROCESS_FLAGS);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+			std::cerr << "Error: importModel: " << importer.GetErrorString() << std::endl;
+			return false;
+		}
+
+		model = {};
+		model.min = glm::vec3(std::numeric_limits<float>::infinity());
+		model.max = glm::vec3(-std::numeric_limits<float>::infinity());
+
+		for (uint i = 0; i < scene->mNumMaterials; i++)
+			model.materials.push_back(importMaterial(model, scene->mMaterials[i]));
+
+		// every mesh indexes a material
+		if (model.materials.empty())
+			model.materials.push_back({});
+
+		std::vector<const aiMesh*> meshes{};
+		collectNode(scene, scene->mRootNode, meshes);
+
+		// the ranges of every mesh are known up front, the blobs are allocated once
+		uint vertex_count = 0;
+		uint index_count = 0;
+
+		for (const aiMesh* mesh : meshes) {
+			MeshRecord record{};
+			record.first_vertex = vertex_count;
+			record.vertex_count = mesh->mNumVertices;
+			record.first_index = index_count;
+			record.index_count = countIndices(mesh);
+			record.material = mesh->mMaterialIndex;
+
+			vertex_count += record.vertex_count;
+			index_count += record.index_count;
+
+			model.meshes.push_back(record);
+		}
+
+		model.vertices.resize(vertex_count);
+		model.indices.resize(index_count);
+
+		dlb::ThreadPool::getInstance().parallelFor(meshes.size(), 1, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++)
+				convertMesh(model, meshes[i], model.meshes[i]);
+		});
+
+		shareIdenticalMeshes(model);
+
+		for (const auto& record : model.meshes) {
+			model.min = glm::min(model.min, record.min);
+			model.max = glm::max(model.max, record.max);
+		}
+
+		return true;
+	}
+}
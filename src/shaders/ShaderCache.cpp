@@ -0,0 +1,147 @@
+#include <glad/glad.h>
+
+#include <fstream>
+#include <filesystem>
+#include <format>
+#include <iostream>
+
+#include "ShaderCache.hpp"
+
+namespace dlb {
+	/*
+	* Every cache file starts with this header followed by the binary.
+	*/
+	struct ProgramBinaryHeader {
+		uint magic;
+		uint version;
+		GLenum format;
+		uint length;
+	};
+
+	static constexpr uint PROGRAM_BINARY_MAGIC = 0x504c4244; // "DBLP"
+	static constexpr uint PROGRAM_BINARY_VERSION = 1;
+
+	static u64 fnv1a(u64 hash, const void* data, size_t size) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	bool ShaderCache::available() {
+		if (available_ < 0) {
+			GLint formats = 0;
+
+			if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary)
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+			available_ = formats > 0;
+
+			driver_ = std::format("{}|{}|{}",
+				(const char*)glGetString(GL_VENDOR),
+				(const char*)glGetString(GL_RENDERER),
+				(const char*)glGetString(GL_VERSION));
+		}
+
+		return enabled_ && available_ == 1;
+	}
+
+	u64 ShaderCache::key(const std::vector<std::string>& sources) {
+		available();
+
+		u64 hash = 0xcbf29ce484222325ull;
+
+		hash = fnv1a(hash, &PROGRAM_BINARY_VERSION, sizeof(PROGRAM_BINARY_VERSION));
+		hash = fnv1a(hash, driver_.data(), driver_.size());
+
+		for (const auto& source : sources) {
+			u64 size = source.size();
+			hash = fnv1a(hash, &size, sizeof(size));
+			hash = fnv1a(hash, source.data(), source.size());
+		}
+
+		return hash;
+	}
+
+	std::string ShaderCache::path(u64 key) const {
+		return std::format("{}/{:016x}.bin", directory_, key);
+	}
+
+	bool ShaderCache::load(u64 key, GLuint program) {
+		if (!available())
+			return false;
+
+		std::ifstream file{ path(key), std::ios::binary };
+
+		if (!file.is_open())
+			return false;
+
+		ProgramBinaryHeader header{};
+		file.read((char*)&header, sizeof(header));
+
+		if (!file || header.magic != PROGRAM_BINARY_MAGIC || header.version != PROGRAM_BINARY_VERSION)
+			return false;
+
+		std::vector<char> binary(header.length);
+		file.read(binary.data(), binary.size());
+
+		if (!file)
+			return false;
+
+		glProgramBinary(program, header.format, binary.data(), binary.size());
+
+		GLint success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		if (!success) {
+			// the driver rejected it (e.g. after an update with the same version string)
+			std::cout << "[SHADER CACHE] Stale binary " << path(key) << std::endl;
+			file.close();
+			std::filesystem::remove(path(key));
+			return false;
+		}
+
+		return true;
+	}
+
+	void ShaderCache::store(u64 key, GLuint program) {
+		if (!available())
+			return;
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length <= 0)
+			return;
+
+		std::vector<char> binary(length);
+		ProgramBinaryHeader header{ PROGRAM_BINARY_MAGIC, PROGRAM_BINARY_VERSION, 0, 0 };
+		glGetProgramBinary(program, length, nullptr, &header.format, binary.data());
+		header.length = length;
+
+		std::error_code ec;
+		std::filesystem::create_directories(directory_, ec);
+
+		// write to a temporary file so a crash never leaves a truncated entry
+		std::string final_path = path(key);
+		std::string tmp_path = final_path + ".tmp";
+
+		{
+			std::ofstream file{ tmp_path, std::ios::binary | std::ios::trunc };
+
+			if (!file.is_open()) {
+				std::cout << "[SHADER CACHE] Can not write " << tmp_path << std::endl;
+				return;
+			}
+
+			file.write((const char*)&header, sizeof(header));
+			file.write(binary.data(), binary.size());
+		}
+
+		std::filesystem::rename(tmp_path, final_path, ec);
+	}
+}
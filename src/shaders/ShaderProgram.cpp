@@ -3,36 +3,229 @@
 #include <gl/GL.h>
 
 #include <iostream>
+#include <format>
+#include <cassert>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "ShaderProgram.hpp"
+#include "ShaderCache.hpp"
+#include "profiling/CpuProfiler.hpp"
+#include "profiling/LoadStats.hpp"
 
 #include "io/FileReader.hpp"
 
 namespace dlb {
+	/*
+	* Injects the permutation defines, and the vertex inputs in the vertex
+	*	stage, right after the #version line.
+	*/
+	std::string ShaderProgramBuilder::preprocess(std::string_view source, GLenum type) const {
+		const bool inject_inputs = type == GL_VERTEX_SHADER && !vertex_inputs_.empty();
+
+		if (defines_.empty() && !inject_inputs)
+			return std::string(source);
+
+		std::string defines;
+
+		for (const auto& name : defines_)
+			defines += std::format("#define {} 1\n", name);
+
+		if (inject_inputs)
+			defines += vertex_inputs_;
+
+		size_t version = source.find("#version");
+		size_t insert_at = version == std::string_view::npos ? 0 : source.find('\n', version);
+
+		if (insert_at == std::string_view::npos)
+			return std::string(source) + "\n" + defines;
+
+		std::string result{ source };
+		result.insert(version == std::string_view::npos ? 0 : insert_at + 1, defines);
+		return result;
+	}
+
+	/*
+	* "res://shaders/Model.vert + res://shaders/Model.frag [NO_TEXTURES]"
+	*/
+	static std::string programName(const std::vector<ShaderProgramBuilder::Shader>& shaders, const std::vector<std::string>& defines) {
+		std::string name{};
+
+		for (const auto& shader : shaders)
+			name += (name.empty() ? "" : " + ") + shader.path;
+
+		for (const auto& define : defines)
+			name += " [" + define + "]";
+
+		return name;
+	}
+
 	ShaderProgram ShaderProgramBuilder::build() {
-		this->shader_program = glCreateProgram();
-
-		for (auto& shader : this->shaders) {
-			shader.shaderId = glCreateShader(shader.type);
-			std::string shaderContent = FileReader::read(shader.path);
-			const char* data = shaderContent.data();
-			glShaderSource(shader.shaderId, 1, &data, NULL);
-			glCompileShader(shader.shaderId);
-			checkCompileErrors(shader.shaderId);
-			glAttachShader(this->shader_program, shader.shaderId);
+		ShaderBatch batch{};
+		batch.add(*this);
+		batch.submit();
+		return batch.finish(0);
+	}
+
+	void ShaderBatch::enableParallelCompile() {
+		if (GLAD_GL_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+
+	uint ShaderBatch::add(const ShaderProgramBuilder& builder) {
+		Entry entry{};
+		entry.builder = builder;
+		entries_.push_back(std::move(entry));
+		return entries_.size() - 1;
+	}
+
+	void ShaderBatch::submit() {
+		PROFILE_ZONE("ShaderBatch::submit");
+
+		auto& cache = ShaderCache::getInstance();
+
+		std::vector<Entry*> compiling{};
+
+		// every source of the batch is read in at once
+		std::vector<std::string> paths{};
+
+		for (const auto& entry : entries_) {
+			if (entry.state == State::Queued) {
+				for (const auto& shader : entry.builder.shaders)
+					paths.push_back(shader.path);
+			}
 		}
 
-		glLinkProgram(shader_program);
+		std::vector<FileView> files = FileReader::openBatch(paths);
+		size_t next_file = 0;
+
+		for (auto& entry : entries_) {
+			if (entry.state != State::Queued)
+				continue;
+
+			auto& builder = entry.builder;
+			entry.name = programName(builder.shaders, builder.defines_);
 
-		checkCompileErrors(-1);
+			ScopedLoadTimer timer{ LoadPhase::ShaderCompile, entry.name };
 
-		for (auto& shader : this->shaders)
+			entry.program = glCreateProgram();
+			entry.state = State::Compiling;
+
+			std::vector<std::string> sources{};
+
+			for (auto& shader : builder.shaders) {
+				const FileView& file = files[next_file++];
+				timer.addBytesRead(file.size());
+
+				// compiles as an empty stage, the link error names the program
+				if (!file)
+					std::cerr << "[SHADER BUILDER] " << shader.path << ": " << fileErrorString(file.error()) << std::endl;
+
+				shader.source = builder.preprocess(file.text(), shader.type);
+				sources.push_back(shader.source);
+			}
+
+			if (builder.use_cache_ && cache.available()) {
+				entry.cache_key = cache.key(sources);
+				entry.from_cache = cache.load(entry.cache_key, entry.program);
+			}
+
+			if (!entry.from_cache)
+				compiling.push_back(&entry);
+		}
+
+		// no status query between these two loops, every compile is in flight before the first link
+		for (auto* entry : compiling) {
+			ScopedLoadTimer timer{ LoadPhase::ShaderCompile, entry->name };
+
+			for (auto& shader : entry->builder.shaders) {
+				shader.shaderId = glCreateShader(shader.type);
+				const char* data = shader.source.data();
+				glShaderSource(shader.shaderId, 1, &data, NULL);
+				glCompileShader(shader.shaderId);
+			}
+		}
+
+		for (auto* entry : compiling) {
+			ScopedLoadTimer timer{ LoadPhase::ShaderLink, entry->name };
+
+			for (auto& shader : entry->builder.shaders)
+				glAttachShader(entry->program, shader.shaderId);
+
+			if (entry->builder.use_cache_ && cache.available())
+				glProgramParameteri(entry->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+			glLinkProgram(entry->program);
+		}
+	}
+
+	bool ShaderBatch::isComplete(uint i) const {
+		const auto& entry = entries_[i];
+
+		if (entry.state == State::Queued)
+			return false;
+
+		if (entry.state == State::Finished || entry.from_cache)
+			return true;
+
+		// without the extension any query blocks, report complete and let finish() wait
+		if (!GLAD_GL_KHR_parallel_shader_compile)
+			return true;
+
+		GLint done = GL_FALSE;
+		glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &done);
+		return done == GL_TRUE;
+	}
+
+	ShaderProgram ShaderBatch::finish(uint i) {
+		PROFILE_ZONE("ShaderBatch::finish");
+
+		auto& entry = entries_[i];
+
+		assert(entry.state == State::Compiling && "Program must be submitted and not finished");
+
+		// blocks on the driver unless the link already finished
+		ScopedLoadTimer timer{ LoadPhase::ShaderLink, entry.name };
+
+		entry.state = State::Finished;
+
+		if (entry.from_cache)
+			return ShaderProgram{ (int)entry.program };
+
+		auto& builder = entry.builder;
+		builder.shader_program = entry.program;
+
+		for (auto& shader : builder.shaders)
+			builder.checkCompileErrors(shader.shaderId);
+
+		builder.checkCompileErrors(-1);
+
+		for (auto& shader : builder.shaders) {
+			glDetachShader(entry.program, shader.shaderId);
 			glDeleteShader(shader.shaderId);
+		}
 
-		return ShaderProgram{ shader_program };
+		GLint success = 0;
+		glGetProgramiv(entry.program, GL_LINK_STATUS, &success);
+
+		auto& cache = ShaderCache::getInstance();
+
+		if (builder.use_cache_ && success && cache.available())
+			cache.store(entry.cache_key, entry.program);
+
+		// the builder keeps the sources, drop them once the program exists
+		for (auto& shader : builder.shaders)
+			shader.source = {};
+
+		// an empty slot, getShader() keeps drawing with the placeholder
+		if (!success) {
+			std::cerr << "[SHADER BUILDER] " << entry.name << " failed to link" << std::endl;
+			glDeleteProgram(entry.program);
+			entry.program = 0;
+		}
+
+		return ShaderProgram{ (int)entry.program };
 	}
 
 	void ShaderProgramBuilder::checkCompileErrors(int current) {
@@ -54,40 +247,44 @@ namespace dlb {
 		}
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, bool value) const {
-		glUniform1i(glGetUniformLocation(program_id, name.c_str()), static_cast<int>(value));
+	void ShaderProgram::setUniform(const char* name, bool value) const {
+		glUniform1i(glGetUniformLocation(program_id, name), static_cast<int>(value));
+	}
+
+	void ShaderProgram::setUniform(const char* name, int value) const {
+		glUniform1i(glGetUniformLocation(program_id, name), value);
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, int value) const {
-		glUniform1i(glGetUniformLocation(program_id, name.c_str()), value);
+	void ShaderProgram::setUniform(const char* name, float value) const {
+		glUniform1f(glGetUniformLocation(program_id, name), value);
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, float value) const {
-		glUniform1f(glGetUniformLocation(program_id, name.c_str()), value);
+	void ShaderProgram::setUniform(const char* name, const glm::vec2& value) const {
+		glUniform2fv(glGetUniformLocation(program_id, name), 1, glm::value_ptr(value));
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, const glm::vec2& value) const {
-		glUniform2fv(glGetUniformLocation(program_id, name.c_str()), 1, glm::value_ptr(value));
+	void ShaderProgram::setUniform(const char* name, const glm::vec3& value) const {
+		glUniform3fv(glGetUniformLocation(program_id, name), 1, glm::value_ptr(value));
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, const glm::vec3& value) const {
-		glUniform3fv(glGetUniformLocation(program_id, name.c_str()), 1, glm::value_ptr(value));
+	void ShaderProgram::setUniform(const char* name, const glm::vec4& value) const {
+		glUniform4fv(glGetUniformLocation(program_id, name), 1, glm::value_ptr(value));
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, const glm::vec4& value) const {
-		glUniform4fv(glGetUniformLocation(program_id, name.c_str()), 1, glm::value_ptr(value));
+	void ShaderProgram::setUniform(const char* name, const glm::mat2& value) const {
+		glUniformMatrix2fv(glGetUniformLocation(program_id, name), 1, GL_FALSE, glm::value_ptr(value));
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, const glm::mat2& value) const {
-		glUniformMatrix2fv(glGetUniformLocation(program_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+	void ShaderProgram::setUniform(const char* name, const glm::mat3& value) const {
+		glUniformMatrix3fv(glGetUniformLocation(program_id, name), 1, GL_FALSE, glm::value_ptr(value));
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, const glm::mat3& value) const {
-		glUniformMatrix3fv(glGetUniformLocation(program_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+	void ShaderProgram::setUniform(const char* name, const glm::mat4& value) const {
+		glUniformMatrix4fv(glGetUniformLocation(program_id, name), 1, GL_FALSE, glm::value_ptr(value));
 	}
 
-	void ShaderProgram::setUniform(const std::string& name, const glm::mat4& value) const {
-		glUniformMatrix4fv(glGetUniformLocation(program_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+	void ShaderProgram::setUniform(const char* name, const int* values, int count) const {
+		glUniform1iv(glGetUniformLocation(program_id, name), count, values);
 	}
 
 	void ShaderProgram::use() const {
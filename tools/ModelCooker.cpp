@@ -0,0 +1,103 @@
+/*
+* Offline model cooker: imports every model given on the command line with
+* assimp and writes the .dlbm file that scene::Model maps at runtime, then
+* block compresses the textures of the model into their KTX2 cache.
+*
+*	ModelCooker <model> [<model> ...]	writes <model>.dlbm next to every model
+*	ModelCooker <model> -o <file>		writes <file>
+*	--no-textures				skips the texture cache
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+
+#include <stb_image/stb_image.h>
+
+#include "Texture.hpp"
+#include "scene/ModelFile.hpp"
+#include "render/TextureCache.hpp"
+
+/*
+* Writes the KTX2 cache of every texture the model references, skipped
+* when it is up to date.
+*/
+static int cookTextures(const std::string& input, const scene::ModelData& model) {
+	const std::string directory = input.substr(0, input.find_last_of("\\/") + 1);
+	const auto view = model.view();
+
+	int failed = 0;
+	size_t bytes = 0;
+
+	for (const auto& texture : model.textures) {
+		dlb::CompressedImage image{};
+
+		if (!dlb::loadCompressedTexture(directory + std::string(view.texturePath(texture)), texture.type == dlb::Texture2DType::Normal, image)) {
+			failed++;
+			continue;
+		}
+
+		bytes += image.bytes();
+	}
+
+	std::cout << "[COOKER] " << model.textures.size() - failed << " textures compressed, "
+		<< bytes / 1024 << " KiB with mips" << std::endl;
+
+	return failed == 0 ? 0 : 1;
+}
+
+static int cook(const std::string& input, const std::string& output, bool textures) {
+	auto start = std::chrono::steady_clock::now();
+
+	scene::ModelData model{};
+
+	if (!scene::importModel(input, model)) {
+		std::cerr << "[COOKER] Could not import " << input << std::endl;
+		return 1;
+	}
+
+	if (!scene::writeModelFile(output, model.view()))
+		return 1;
+
+	auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "[COOKER] " << input << " -> " << output << ": "
+		<< model.meshes.size() << " meshes, "
+		<< model.vertices.size() << " vertices, "
+		<< model.indices.size() << " indices, "
+		<< model.materials.size() << " materials in " << ms << " ms" << std::endl;
+
+	return textures ? cookTextures(input, model) : 0;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> inputs{};
+	std::string output{};
+	bool textures = true;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			output = argv[++i];
+		else if (std::strcmp(argv[i], "--no-textures") == 0)
+			textures = false;
+		else
+			inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty() || (!output.empty() && inputs.size() != 1)) {
+		std::cerr << "usage: ModelCooker <model> [<model> ...]" << std::endl;
+		std::cerr << "       ModelCooker <model> -o <file>" << std::endl;
+		return 1;
+	}
+
+	// the cache must match the orientation the application decodes with
+	stbi_set_flip_vertically_on_load(true);
+
+	int failed = 0;
+
+	for (const auto& input : inputs)
+		failed += cook(input, output.empty() ? scene::cookedModelPath(input) : output, textures);
+
+	return failed == 0 ? 0 : 1;
+}
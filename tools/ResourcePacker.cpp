@@ -0,0 +1,190 @@
+/*
+* Resource packer: writes every file under a resource directory into one
+* .dlbp pack that dlb::VirtualFileSystem maps at runtime (`--pack <file>`).
+* Cook the models and textures first, the .dlbm and KTX2 files are stored
+* as they are and used in place.
+*
+*	ResourcePacker <resource dir> <pack>
+*	--no-compression		stores every entry uncompressed
+*/
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <cctype>
+
+#include "io/PackFile.hpp"
+#include "io/VirtualFileSystem.hpp"
+#include "io/Lz4.hpp"
+
+struct PackInput {
+	std::string path;
+	std::string name;
+	dlb::PackEntry entry;
+};
+
+/*
+* Mapped and used in place at runtime (cooked models, block compressed
+* textures) or already entropy coded, LZ4 would only cost a copy.
+*/
+static bool isStoredAsIs(const std::filesystem::path& path) {
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+	for (const char* stored : { ".dlbm", ".ktx2", ".png", ".jpg", ".jpeg" }) {
+		if (extension == stored)
+			return true;
+	}
+
+	return false;
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& bytes) {
+	std::ifstream file{ path, std::ios::binary };
+
+	if (!file.is_open())
+		return false;
+
+	bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static void pad(std::ofstream& file, u64& offset) {
+	static const char zeros[dlb::PACK_ALIGNMENT] = {};
+
+	const u64 aligned = (offset + dlb::PACK_ALIGNMENT - 1) / dlb::PACK_ALIGNMENT * dlb::PACK_ALIGNMENT;
+	file.write(zeros, aligned - offset);
+	offset = aligned;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> arguments{};
+	bool compress = true;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--no-compression") == 0)
+			compress = false;
+		else
+			arguments.push_back(argv[i]);
+	}
+
+	if (arguments.size() != 2) {
+		std::cerr << "usage: ResourcePacker <resource dir> <pack> [--no-compression]" << std::endl;
+		return 1;
+	}
+
+	const std::filesystem::path root = arguments[0];
+	const std::string output = arguments[1];
+
+	std::vector<PackInput> inputs{};
+	std::error_code error{};
+
+	for (const auto& file : std::filesystem::recursive_directory_iterator(root, error)) {
+		if (!file.is_regular_file() || file.path().extension() == dlb::PACK_FILE_EXTENSION)
+			continue;
+
+		PackInput input{};
+		input.path = file.path().string();
+		input.name = dlb::VirtualFileSystem::normalize(file.path().lexically_relative(root).generic_string());
+		inputs.push_back(std::move(input));
+	}
+
+	if (error) {
+		std::cerr << "[PACKER] Could not list " << root.string() << ": " << error.message() << std::endl;
+		return 1;
+	}
+
+	std::ofstream file{ output, std::ios::binary | std::ios::trunc };
+
+	if (!file.is_open()) {
+		std::cerr << "[PACKER] Could not open " << output << " for writing" << std::endl;
+		return 1;
+	}
+
+	dlb::PackHeader header{};
+	file.write((const char*)&header, sizeof(header));
+
+	u64 offset = sizeof(header);
+	u64 total_size = 0;
+	uint compressed_count = 0;
+	std::string strings{};
+
+	std::vector<unsigned char> bytes{};
+	std::vector<unsigned char> compressed{};
+
+	for (auto& input : inputs) {
+		if (!readFile(input.path, bytes)) {
+			std::cerr << "[PACKER] Could not read " << input.path << std::endl;
+			return 1;
+		}
+
+		pad(file, offset);
+
+		auto& entry = input.entry;
+		entry.hash = dlb::hashPackPath(input.name);
+		entry.offset = offset;
+		entry.size = bytes.size();
+		entry.stored_size = bytes.size();
+		entry.path_offset = strings.size();
+		entry.path_length = input.name.size();
+		strings += input.name;
+
+		const unsigned char* stored = bytes.data();
+
+		if (compress && !isStoredAsIs(input.path)) {
+			compressed.resize(dlb::lz4CompressBound(bytes.size()));
+			const size_t compressed_size = dlb::lz4Compress(bytes.data(), bytes.size(), compressed.data(), compressed.size());
+
+			// a small saving is not worth the decompression
+			if (compressed_size && compressed_size < bytes.size() * 9 / 10) {
+				entry.flags |= dlb::PackLz4;
+				entry.stored_size = compressed_size;
+				stored = compressed.data();
+				compressed_count++;
+			}
+		}
+
+		file.write((const char*)stored, entry.stored_size);
+		offset += entry.stored_size;
+		total_size += entry.size;
+	}
+
+	std::sort(inputs.begin(), inputs.end(), [](const PackInput& a, const PackInput& b) {
+		return a.entry.hash != b.entry.hash ? a.entry.hash < b.entry.hash : a.name < b.name;
+	});
+
+	pad(file, offset);
+
+	std::memcpy(header.magic, dlb::PACK_FILE_MAGIC, sizeof(header.magic));
+	header.version = dlb::PACK_FILE_VERSION;
+	header.entry_count = inputs.size();
+	header.index_offset = offset;
+
+	for (const auto& input : inputs)
+		file.write((const char*)&input.entry, sizeof(input.entry));
+
+	offset += inputs.size() * sizeof(dlb::PackEntry);
+
+	header.strings_offset = offset;
+	header.strings_size = strings.size();
+	file.write(strings.data(), strings.size());
+	offset += strings.size();
+
+	file.seekp(0);
+	file.write((const char*)&header, sizeof(header));
+
+	if (!file.good()) {
+		std::cerr << "[PACKER] Could not write " << output << std::endl;
+		return 1;
+	}
+
+	std::cout << "[PACKER] " << root.string() << " -> " << output << ": "
+		<< inputs.size() << " files (" << compressed_count << " compressed), "
+		<< total_size / 1024 << " KiB -> " << offset / 1024 << " KiB" << std::endl;
+
+	return 0;
+}